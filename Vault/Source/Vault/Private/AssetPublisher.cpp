@@ -3,10 +3,16 @@
 #include "AssetPublisher.h"
 #include "Vault.h"
 #include "VaultSettings.h"
+#include "VaultConnectionMonitor.h"
+#include "VaultLibraryLayout.h"
 #include "PakFileUtilities.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeExit.h"
+#include "HAL/FileManager.h"
 #include "GenericPlatform/GenericPlatformMisc.h"
 #include "MetadataOps.h"
+#include "VaultLibraryIndex.h"
+#include "VaultLibraryJournal.h"
 #include <AssetRegistryModule.h>
 #include "Slate.h"
 #include "SlateExtras.h"
@@ -14,6 +20,39 @@
 
 #define LOCTEXT_NAMESPACE "FVaultPublisher"
 
+namespace VaultPublisherUtils
+{
+	// UUIDv7 layout: 48 bit unix time in milliseconds, version and variant bits, the rest random.
+	// Ids sort by creation time, which keeps directory listings and the library index in publishing order.
+	static FString MakeTimeOrderedId()
+	{
+		const uint64 UnixMilliseconds = static_cast<uint64>((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds());
+		const FGuid Random = FGuid::NewGuid();
+
+		uint8 Bytes[16];
+		for (int32 ByteIndex = 0; ByteIndex < 6; ByteIndex++)
+		{
+			Bytes[ByteIndex] = static_cast<uint8>(UnixMilliseconds >> (8 * (5 - ByteIndex)));
+		}
+		const uint32 RandomWords[3] = { Random.B, Random.C, Random.D };
+		for (int32 ByteIndex = 6; ByteIndex < 16; ByteIndex++)
+		{
+			const int32 RandomByte = ByteIndex - 6;
+			Bytes[ByteIndex] = static_cast<uint8>(RandomWords[RandomByte / 4] >> (8 * (RandomByte % 4)));
+		}
+		Bytes[6] = 0x70 | (Bytes[6] & 0x0F);
+		Bytes[8] = 0x80 | (Bytes[8] & 0x3F);
+
+		FString Id;
+		Id.Reserve(32);
+		for (const uint8 Byte : Bytes)
+		{
+			Id += FString::Printf(TEXT("%02x"), Byte);
+		}
+		return Id;
+	}
+}
+
 
 UAssetPublisher::FOnVaultPackagingCompleted UAssetPublisher::OnVaultPackagingCompletedDelegate;
 
@@ -53,13 +92,14 @@ bool UAssetPublisher::PackageSelected(TSet<FString> PackageObjects, FVaultMetada
 	
 	FFileHelper::SaveStringArrayToFile(PackageObjects.Array(), *TextDocFull);
 	
-	const FString Root = FVaultSettings::Get().GetAssetLibraryRoot();
-	
-	const FString Filename = Meta.FileId.ToString() + TEXT(".upack");
+	const FString PackFileOutput = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), Meta.FileId, TEXT("upack"));
+
+	// The pack may be the first one in its shard.
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(PackFileOutput), true);
 
 	// Wrap Our Path in Quotes for use in Command-Line
 	
-	const FString PackFilePath = Quote + (Root / Filename) + Quote;
+	const FString PackFilePath = Quote + PackFileOutput + Quote;
 	
 	// Convert String to parsable command. Ensures path is wrapped in quotes in case of spaces in name
 	const FString Command = FString::Printf(TEXT("%s -create=%s -compressed"), *PackFilePath, *TextDocFull);
@@ -76,6 +116,8 @@ bool UAssetPublisher::PackageSelected(TSet<FString> PackageObjects, FVaultMetada
 	// Metadata Writing
 
 	FMetadataOps::WriteMetadata(Meta);
+	FVaultLibraryIndex::AddOrUpdateEntry(Meta);
+	FVaultLibraryJournal::Append(FVaultSettings::Get().GetAssetLibraryRoot(), EVaultJournalOp::Publish, Meta.FileId);
 	FMetadataOps::CopyMetadataToLocal(Meta);
 	SubPackageTask.EnterProgressFrame(0.2f);
 	OnVaultPackagingCompletedDelegate.ExecuteIfBound();
@@ -199,8 +241,11 @@ FReply UAssetPublisher::TryPackageAsset(FString FileId, FAssetData ExportAsset,
 	const FString OutputDirectory = FVaultSettings::Get().GetAssetLibraryRoot();
 
 	// if outputdirectory can't be found and can't be created we might have lost connection
-	if (!FVaultSettings::Get().CheckConnection())
+	if (!FVaultConnectionMonitor::Get().IsReachable())
 	{
+		// Have another look, so trying again in a moment works once the share is back.
+		FVaultConnectionMonitor::Get().RequestProbe(true);
+
 		const FText ErrorMsg = LOCTEXT("OutputDirectoryNotFoundMsg", "Vault folder wasn't found! Check your network connection if it is located on a network share.");
 		const FText ErrorTitle = LOCTEXT("OutputDirectoryNotFoundTitle", "Output Directory not found");
 
@@ -212,21 +257,6 @@ FReply UAssetPublisher::TryPackageAsset(FString FileId, FAssetData ExportAsset,
 		return FReply::Handled();
 	}
 
-	// Pack file path, only used here for duplicate detection
-	const FString PackageFileOutput = OutputDirectory / FileId + TEXT(".upack");
-
-
-	if (FPaths::FileExists(PackageFileOutput))
-	{
-
-		const FText ErrorMsg = LOCTEXT("TryFileOverwriteMsg", "The vault already contains a file with this name! You should never see this message... if you do please contact a developer!");
-		const FText ErrorTitle = LOCTEXT("TryFileOverwriteTitle", "This should not have happened...");
-
-		const EAppReturnType::Type Confirmation = FMessageDialog::Open(
-			EAppMsgType::Ok, ErrorMsg, &ErrorTitle);
-		return FReply::Handled();
-	}
-
 	FVaultMetadata ExistingMeta = FindMetadataByPackName(AssetPublishMetadata.PackName);
 
 	if (ExistingMeta.IsMetaValid())
@@ -250,6 +280,38 @@ FReply UAssetPublisher::TryPackageAsset(FString FileId, FAssetData ExportAsset,
 		}
 	}
 
+	// A new pack claims its FileId only once the share has answered, so an attempt that can't publish leaves nothing behind.
+	// The claim is given up again on the way out, unless publishing wrote the .meta file.
+	FName ClaimedFileId;
+	ON_SCOPE_EXIT
+	{
+		if (!ClaimedFileId.IsNone())
+		{
+			ReleasePackageFilename(ClaimedFileId);
+		}
+	};
+
+	if (FileId.IsEmpty())
+	{
+		ClaimedFileId = CreateUniquePackageFilename();
+		AssetPublishMetadata.FileId = ClaimedFileId;
+		FileId = ClaimedFileId.ToString();
+
+		// Pack file path, only used here for duplicate detection
+		const FString PackageFileOutput = FVaultLibraryLayout::GetPackFilePath(OutputDirectory, ClaimedFileId, TEXT("upack"));
+
+		if (FPaths::FileExists(PackageFileOutput))
+		{
+
+			const FText ErrorMsg = LOCTEXT("TryFileOverwriteMsg", "The vault already contains a file with this name! You should never see this message... if you do please contact a developer!");
+			const FText ErrorTitle = LOCTEXT("TryFileOverwriteTitle", "This should not have happened...");
+
+			const EAppReturnType::Type Confirmation = FMessageDialog::Open(
+				EAppMsgType::Ok, ErrorMsg, &ErrorTitle);
+			return FReply::Handled();
+		}
+	}
+
 	
 	
 
@@ -315,7 +377,7 @@ FReply UAssetPublisher::TryPackageAsset(FString FileId, FAssetData ExportAsset,
 	}
 	//GetAssetDependenciesRecursive(ExportAsset.PackageName, AssetsToProcess, OriginalRootString);
 
-	const FString ScreenshotPath = OutputDirectory / FileId + TEXT(".png");
+	const FString ScreenshotPath = FVaultLibraryLayout::GetPackFilePath(OutputDirectory, FName(*FileId), TEXT("png"));
 
 	FImageWriteOptions Params;
 	Params.bAsync = true;
@@ -415,7 +477,7 @@ bool UAssetPublisher::RenamePackage(FName NewPackName, FVaultMetadata Meta)
 	{
 		return false;
 	}
-	else if (FindMetadataByPackName(NewPackName).IsMetaValid())
+	else if (IsPackNameInUse(NewPackName))
 	{
 		UE_LOG(LogVault, Error, TEXT("PackName is already being used."));
 		return false;
@@ -424,54 +486,71 @@ bool UAssetPublisher::RenamePackage(FName NewPackName, FVaultMetadata Meta)
 	Meta.PackName = NewPackName;
 
 	FMetadataOps::WriteMetadata(Meta);
+	FVaultLibraryIndex::AddOrUpdateEntry(Meta);
+	FVaultLibraryJournal::Append(FVaultSettings::Get().GetAssetLibraryRoot(), EVaultJournalOp::Rename, Meta.FileId);
 
 	return true;
 }
 
-FName UAssetPublisher::CreateUniquePackageFilename(int length)
+FName UAssetPublisher::CreateUniquePackageFilename()
 {
-	const FString AlpahNum = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuv";
+	const FString LibraryRoot = FVaultSettings::Get().GetAssetLibraryRoot();
 
-	FName Filename;
+	// A collision needs two ids made in the same millisecond with the same 74 random bits, the retries are only for form's sake.
+	static const int32 MaxAttempts = 8;
 
-	bool IsUnique = false;
+	FName FileId;
+	for (int32 Attempt = 0; Attempt < MaxAttempts; Attempt++)
+	{
+		FileId = FName(*VaultPublisherUtils::MakeTimeOrderedId());
 
-	FVaultModule::Get().UpdateMetaFilesCache();
+		const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(LibraryRoot, FileId, TEXT("meta"));
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(MetaFilePath), true);
 
-	while (!IsUnique)
-	{
-		FString temp = "";
-		for (int i = 0; i < length; i++)
+		if (FVaultLibraryLayout::CreateFileExclusive(MetaFilePath))
 		{
-			temp.AppendChar(AlpahNum.GetCharArray()[FMath::RandRange(0, AlpahNum.Len())]);
+			return FileId;
 		}
 
-		Filename = FName(*temp);
-		IsUnique = true;
-
-		for (auto Meta : FVaultModule::Get().MetaFilesCache)
+		// Anything but an existing file means the share can't be written to. Publishing reports that itself.
+		if (!FPaths::FileExists(MetaFilePath))
 		{
-			if (Meta.FileId == Filename)
-			{
-				IsUnique = false;
-				break;
-			}
+			UE_LOG(LogVault, Warning, TEXT("Unable to claim FileId %s in the asset library."), *FileId.ToString());
+			return FileId;
 		}
 	}
 
-	return Filename;
+	UE_LOG(LogVault, Error, TEXT("Unable to find an unused FileId after %d attempts."), MaxAttempts);
+	return FileId;
+}
+
+void UAssetPublisher::ReleasePackageFilename(FName FileId)
+{
+	const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), FileId, TEXT("meta"));
+
+	// Only the empty placeholder, a written .meta file belongs to a published pack.
+	if (IFileManager::Get().FileSize(*MetaFilePath) == 0)
+	{
+		IFileManager::Get().Delete(*MetaFilePath, false, true, true);
+	}
 }
 
 FVaultMetadata UAssetPublisher::FindMetadataByPackName(FName PackName)
 {
-	for (auto Meta : FVaultModule::Get().MetaFilesCache)
+	const FVaultLibrarySnapshotPtr Library = FVaultModule::Get().GetLibrarySnapshot();
+	if (!Library.IsValid())
 	{
-		if (Meta.PackName.IsEqual(PackName))
-		{
-			return Meta;
-		}
+		return FVaultMetadata();
 	}
-	return FVaultMetadata();
+
+	const FVaultMetadata* Meta = Library->FindByPackName(PackName);
+	return Meta ? *Meta : FVaultMetadata();
+}
+
+bool UAssetPublisher::IsPackNameInUse(FName PackName)
+{
+	const FVaultLibrarySnapshotPtr Library = FVaultModule::Get().GetLibrarySnapshot();
+	return Library.IsValid() && Library->FindByPackName(PackName) != nullptr;
 }
 
 FVaultCategory UAssetPublisher::GetAssetCategory(FAssetData AssetData)
@@ -3,42 +3,296 @@
 #include "MetadataOps.h"
 #include "Vault.h"
 #include "VaultSettings.h"
+#include "VaultLibraryLayout.h"
 
 #include "Misc/Paths.h"
 #include "Misc/DateTime.h"
 #include "JsonUtilities/Public/JsonUtilities.h"
 #include "HAL/FileManager.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/LruCache.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/AutomationTest.h"
 
+const int32 FMetadataOps::MaxIngestionWorkers = 8;
+const int32 FMetadataOps::DetailsCacheSize = 64;
 
-FVaultMetadata FMetadataOps::ReadMetadata(FString File)
+// Heavy fields of recently viewed packs. LastModified tells us if the pack was republished since.
+struct FVaultMetadataDetails
 {
-	// Raw data holder for Json
-	FString MetadataRaw;
-	FFileHelper::LoadFileToString(MetadataRaw, *File);
+	FDateTime LastModified;
+	TSet<FString> ObjectsInPack;
+};
+
+static FCriticalSection DetailsCacheLock;
+static TLruCache<FName, FVaultMetadataDetails> DetailsCache(FMetadataOps::DetailsCacheSize);
+
+// Field by field comparison, operator== on FVaultMetadata only looks at the identifying fields.
+static bool MetadataMatches(const FVaultMetadata& A, const FVaultMetadata& B)
+{
+	return A == B
+		&& A.Category == B.Category
+		&& A.LastModified == B.LastModified
+		&& A.HierarchyBadness == B.HierarchyBadness
+		&& A.MachineID == B.MachineID
+		&& A.Tags.Num() == B.Tags.Num() && A.Tags.Includes(B.Tags)
+		&& A.ObjectsInPack.Num() == B.ObjectsInPack.Num() && A.ObjectsInPack.Includes(B.ObjectsInPack);
+}
+
+// Reads the library both ways and reports if the results and timings differ. Handy to check the parallel path against a real share.
+static FAutoConsoleCommand CompareMetadataIngestionCommand(
+	TEXT("Vault.CompareMetadataIngestion"),
+	TEXT("Reads every .meta file in the asset library serially and in parallel, checks both results match and logs the timings."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const TArray<FString> MetaFiles = FMetadataOps::FindAllMetaFilesInLibrary(FVaultSettings::Get().GetAssetLibraryRoot());
+
+		const double SerialStart = FPlatformTime::Seconds();
+		const TArray<FVaultMetadata> SerialResult = FMetadataOps::ReadMetadataFiles(MetaFiles, false);
+		const double SerialTime = FPlatformTime::Seconds() - SerialStart;
+
+		const double ParallelStart = FPlatformTime::Seconds();
+		const TArray<FVaultMetadata> ParallelResult = FMetadataOps::ReadMetadataFiles(MetaFiles, true);
+		const double ParallelTime = FPlatformTime::Seconds() - ParallelStart;
+
+		bool bMatches = SerialResult.Num() == ParallelResult.Num();
+		for (int32 Index = 0; bMatches && Index < SerialResult.Num(); Index++)
+		{
+			bMatches = MetadataMatches(SerialResult[Index], ParallelResult[Index]);
+		}
+
+		UE_LOG(LogVault, Display, TEXT("Metadata ingestion of %d files: serial %.3fs, parallel %.3fs (%d workers). Results %s."),
+			MetaFiles.Num(), SerialTime, ParallelTime, FMetadataOps::MaxIngestionWorkers, bMatches ? TEXT("match") : TEXT("DIFFER"));
+	}));
 
+// Made up pack with NumObjects entries in its object list, for the tests and benchmarks.
+static FVaultMetadata MakeSyntheticMetadata(int32 NumObjects)
+{
+	FVaultMetadata Source;
+	Source.Author = FName(TEXT("Benchmark"));
+	Source.PackName = FName(TEXT("BenchmarkPack"));
+	Source.FileId = FName(TEXT("BenchmarkFileId"));
+	Source.Description = TEXT("Synthetic pack used to benchmark metadata json reading and writing. \"Quoted\", escaped\\ and\nmultiline.");
+	Source.Category = FVaultCategory::Environment;
+	Source.MachineID = FPlatformMisc::GetLoginId();
+	Source.HierarchyBadness = 2;
+	for (int32 TagIndex = 0; TagIndex < 16; TagIndex++)
+	{
+		Source.Tags.Add(FString::Printf(TEXT("Tag%02d"), TagIndex));
+	}
+	for (int32 ObjectIndex = 0; ObjectIndex < NumObjects; ObjectIndex++)
+	{
+		Source.ObjectsInPack.Add(FString::Printf(TEXT("/Game/Vault/Benchmark/Meshes/SM_BenchmarkObject_%05d"), ObjectIndex));
+	}
+
+	// Dates only survive the round trip with second precision.
+	FDateTime::Parse(FDateTime::UtcNow().ToString(), Source.CreationDate);
+	Source.LastModified = Source.CreationDate;
+
+	return Source;
+}
+
+static FString WriteMetadataWithJsonObject(const FVaultMetadata& Metadata)
+{
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(FMetadataOps::ParseMetadataToJson(Metadata).ToSharedRef(), Writer);
+	return Json;
+}
+
+static FVaultMetadata ReadMetadataWithJsonObject(const FString& Json)
+{
 	TSharedPtr<FJsonObject> JsonMetadata = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(MetadataRaw);
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(Json);
 	FJsonSerializer::Deserialize(JsonReader, JsonMetadata);
+	return FMetadataOps::ParseMetaJsonToVaultMetadata(JsonMetadata);
+}
 
-	return ParseMetaJsonToVaultMetadata(JsonMetadata);
+#if WITH_DEV_AUTOMATION_TESTS
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVaultMetadataIngestionTest, "Vault.MetadataOps.ParallelIngestionMatchesSerial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVaultMetadataIngestionTest::RunTest(const FString& Parameters)
+{
+	static const int32 NumFiles = 256;
+
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("VaultIngestion") / FGuid::NewGuid().ToString();
+
+	// Packs differ in everything the readers parse, so a result landing in the wrong slot can't go unnoticed.
+	for (int32 FileIndex = 0; FileIndex < NumFiles; FileIndex++)
+	{
+		FVaultMetadata Source = MakeSyntheticMetadata(FileIndex % 64);
+		Source.FileId = FName(*FString::Printf(TEXT("IngestionPack%04d"), FileIndex));
+		Source.PackName = Source.FileId;
+		Source.HierarchyBadness = FileIndex % 5;
+		Source.Tags.Add(FString::Printf(TEXT("Pack%04d"), FileIndex));
+
+		if (!TestTrue(TEXT("Synthetic .meta file is written"), FFileHelper::SaveStringToFile(FMetadataOps::WriteMetadataToJson(Source), *(Directory / Source.FileId.ToString() + TEXT(".meta")))))
+		{
+			IFileManager::Get().DeleteDirectory(*Directory, false, true);
+			return false;
+		}
+	}
+
+	const TArray<FString> MetaFiles = FMetadataOps::FindAllMetaFilesInFolder(Directory);
+	TestEqual(TEXT("Every .meta file is listed"), MetaFiles.Num(), NumFiles);
+
+	const double SerialStart = FPlatformTime::Seconds();
+	const TArray<FVaultMetadata> SerialResult = FMetadataOps::ReadMetadataFiles(MetaFiles, false);
+	const double SerialTime = FPlatformTime::Seconds() - SerialStart;
+
+	const double ParallelStart = FPlatformTime::Seconds();
+	const TArray<FVaultMetadata> ParallelResult = FMetadataOps::ReadMetadataFiles(MetaFiles, true);
+	const double ParallelTime = FPlatformTime::Seconds() - ParallelStart;
+
+	if (TestEqual(TEXT("Both paths read every file"), ParallelResult.Num(), SerialResult.Num()))
+	{
+		for (int32 Index = 0; Index < SerialResult.Num(); Index++)
+		{
+			const FString FileId = FPaths::GetBaseFilename(MetaFiles[Index]);
+			TestEqual(TEXT("Serial result is in listing order"), SerialResult[Index].FileId.ToString(), FileId);
+			TestEqual(TEXT("Parallel result is in listing order"), ParallelResult[Index].FileId.ToString(), FileId);
+			TestTrue(FString::Printf(TEXT("Parallel result matches serial for %s"), *FileId), MetadataMatches(SerialResult[Index], ParallelResult[Index]));
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Metadata ingestion of %d files: serial %.3fs, parallel %.3fs (%d workers)."),
+		MetaFiles.Num(), SerialTime, ParallelTime, FMetadataOps::MaxIngestionWorkers));
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
 }
 
-bool FMetadataOps::WriteMetadata(FVaultMetadata& Metadata)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVaultMetadataJsonTest, "Vault.MetadataOps.StreamingJsonMatchesJsonObject", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVaultMetadataJsonTest::RunTest(const FString& Parameters)
 {
-	FString OutputString;
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+	for (const int32 NumObjects : { 0, 1, 500 })
+	{
+		const FVaultMetadata Source = MakeSyntheticMetadata(NumObjects);
+		const FString DomJson = WriteMetadataWithJsonObject(Source);
+		const FString StreamJson = FMetadataOps::WriteMetadataToJson(Source);
 
-	FJsonSerializer::Serialize(ParseMetadataToJson(Metadata).ToSharedRef(), Writer);
+		TestEqual(FString::Printf(TEXT("Written json, %d objects"), NumObjects), StreamJson, DomJson);
 
-	const FString Directory = FVaultSettings::Get().GetAssetLibraryRoot();
-	const FString Filepath = Directory / Metadata.FileId.ToString() + ".meta";
+		// Each reader on the other writer's output as well, so neither can get away with only reading its own.
+		for (const FString& Json : { DomJson, StreamJson })
+		{
+			const FVaultMetadata DomResult = ReadMetadataWithJsonObject(Json);
+
+			FVaultMetadata StreamResult;
+			TestTrue(TEXT("Streaming reader parses the json"), FMetadataOps::ReadMetadataFromJson(Json, StreamResult));
+			TestTrue(FString::Printf(TEXT("Both readers agree, %d objects"), NumObjects), MetadataMatches(DomResult, StreamResult));
+			TestTrue(FString::Printf(TEXT("Streaming reader round trips, %d objects"), NumObjects), MetadataMatches(Source, StreamResult));
+
+			FVaultMetadata HeaderResult;
+			TestTrue(TEXT("Streaming reader parses the header"), FMetadataOps::ReadMetadataFromJson(Json, HeaderResult, true));
+			HeaderResult.ObjectsInPack = Source.ObjectsInPack;
+			TestTrue(TEXT("Header only read matches apart from the object list"), MetadataMatches(Source, HeaderResult));
+		}
+	}
+
+	FVaultMetadata Truncated;
+	const FString Json = FMetadataOps::WriteMetadataToJson(MakeSyntheticMetadata(8));
+	TestFalse(TEXT("Truncated json is rejected"), FMetadataOps::ReadMetadataFromJson(Json.Left(Json.Len() / 2), Truncated));
+
+	// A record read into before must not keep anything the next json leaves out.
+	FVaultMetadata Reused = MakeSyntheticMetadata(8);
+	TestTrue(TEXT("Minimal json parses"), FMetadataOps::ReadMetadataFromJson(TEXT("{\"FileId\":\"B\"}"), Reused, true));
+	TestTrue(TEXT("Reused record keeps no stale fields"), Reused.PackName.IsNone() && Reused.Author.IsNone() && Reused.Tags.Num() == 0
+		&& Reused.ObjectsInPack.Num() == 0 && Reused.Description.IsEmpty() && Reused.MachineID.IsEmpty() && Reused.Category == FVaultCategory::Unknown);
+
+	FVaultMetadata BrokenNested;
+	TestFalse(TEXT("Broken object inside a list is rejected"), FMetadataOps::ReadMetadataFromJson(TEXT("{\"FileId\":\"A\",\"Tags\":[\"Rock\",{\"Key\":}],\"PackName\":\"A\"}"), BrokenNested));
+	TestFalse(TEXT("Broken list inside a list is rejected"), FMetadataOps::ReadMetadataFromJson(TEXT("{\"FileId\":\"A\",\"Tags\":[[\"Rock\" \"Stone\"]],\"PackName\":\"A\"}"), BrokenNested));
+
+	return true;
+}
+
+#endif
+
+// Times the FJsonObject and streaming json paths against each other on made up packs with large object lists.
+static FAutoConsoleCommand BenchmarkMetadataJsonCommand(
+	TEXT("Vault.BenchmarkMetadataJson"),
+	TEXT("Vault.BenchmarkMetadataJson [ObjectsPerPack=500] [Iterations=200]. Writes and reads synthetic metadata through the FJsonObject and the streaming json paths and logs the timings."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumObjects = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 0) : 500;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 200;
+
+		const FVaultMetadata Source = MakeSyntheticMetadata(NumObjects);
+
+		// One untimed round of each path first, so neither pays for first touch allocations and cold caches.
+		FString DomJson = WriteMetadataWithJsonObject(Source);
+		FString StreamJson = FMetadataOps::WriteMetadataToJson(Source);
+		FVaultMetadata DomResult = ReadMetadataWithJsonObject(DomJson);
+		FVaultMetadata StreamResult;
+		FMetadataOps::ReadMetadataFromJson(DomJson, StreamResult);
+
+		// The paths take turns every iteration, so drift over the run lands on both alike.
+		double DomWriteTime = 0.0;
+		double StreamWriteTime = 0.0;
+		double DomReadTime = 0.0;
+		double StreamReadTime = 0.0;
+
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			double Start = FPlatformTime::Seconds();
+			DomJson = WriteMetadataWithJsonObject(Source);
+			DomWriteTime += FPlatformTime::Seconds() - Start;
+
+			Start = FPlatformTime::Seconds();
+			StreamJson = FMetadataOps::WriteMetadataToJson(Source);
+			StreamWriteTime += FPlatformTime::Seconds() - Start;
+
+			Start = FPlatformTime::Seconds();
+			DomResult = ReadMetadataWithJsonObject(DomJson);
+			DomReadTime += FPlatformTime::Seconds() - Start;
+
+			Start = FPlatformTime::Seconds();
+			FMetadataOps::ReadMetadataFromJson(DomJson, StreamResult);
+			StreamReadTime += FPlatformTime::Seconds() - Start;
+		}
+
+		const bool bSameJson = DomJson == StreamJson;
+		const bool bSameMetadata = MetadataMatches(DomResult, StreamResult) && MetadataMatches(Source, StreamResult);
+
+		UE_LOG(LogVault, Display, TEXT("Metadata json, %d objects per pack, %d iterations:"), NumObjects, Iterations);
+		UE_LOG(LogVault, Display, TEXT("  Write: FJsonObject %.2fms, streaming %.2fms per pack. Output %s."),
+			DomWriteTime * 1000.0 / Iterations, StreamWriteTime * 1000.0 / Iterations, bSameJson ? TEXT("identical") : TEXT("DIFFERS"));
+		UE_LOG(LogVault, Display, TEXT("  Read:  FJsonObject %.2fms, streaming %.2fms per pack. Results %s."),
+			DomReadTime * 1000.0 / Iterations, StreamReadTime * 1000.0 / Iterations, bSameMetadata ? TEXT("match") : TEXT("DIFFER"));
+	}));
+
+
+FVaultMetadata FMetadataOps::ReadMetadata(FString File, bool bHeaderOnly)
+{
+	// Raw data holder for Json
+	FString MetadataRaw;
+	FFileHelper::LoadFileToString(MetadataRaw, *File);
+
+	FVaultMetadata Metadata;
+	if (!ReadMetadataFromJson(MetadataRaw, Metadata, bHeaderOnly))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Failed to parse metadata file %s"), *File);
+		return FVaultMetadata();
+	}
+	return Metadata;
+
+}
+
+bool FMetadataOps::WriteMetadata(FVaultMetadata& Metadata)
+{
+	const FString OutputString = WriteMetadataToJson(Metadata);
+
+	const FString Filepath = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), Metadata.FileId, TEXT("meta"));
 	
 	return FFileHelper::SaveStringToFile(OutputString, *Filepath);
 
 }
 
-bool FMetadataOps::DeleteMetadata(FVaultMetadata& Metadata)
+bool FMetadataOps::DeleteMetadata(const FVaultMetadata& Metadata)
 {
 	const FString Directory = FVaultSettings::Get().GetProjectVaultFolder();
 	const FString Filepath = Directory / Metadata.FileId.ToString() + ".meta";
@@ -50,7 +304,7 @@ bool FMetadataOps::DeleteMetadata(FVaultMetadata& Metadata)
 TArray<FVaultMetadata> FMetadataOps::FindAllMetadataInLibrary()
 {
 	const FString LibraryPath = FVaultSettings::Get().GetAssetLibraryRoot();
-	return FindAllMetadataInFolder(LibraryPath);
+	return ReadMetadataFiles(FindAllMetaFilesInLibrary(LibraryPath), true);
 }
 
 TArray<FVaultMetadata> FMetadataOps::FindAllMetadataImportedInProject() {
@@ -58,16 +312,28 @@ TArray<FVaultMetadata> FMetadataOps::FindAllMetadataImportedInProject() {
 	return FindAllMetadataInFolder(ImportedLibraryPath);
 }
 
-TArray<FVaultMetadata> FMetadataOps::FindAllMetadataInFolder(FString PathToFolder) {
-	TArray<FVaultMetadata> MetaList;
+TArray<FVaultMetadata> FMetadataOps::FindAllMetadataInFolder(FString PathToFolder, bool bParallel) {
+	return ReadMetadataFiles(FindAllMetaFilesInFolder(PathToFolder), bParallel);
+}
+
+TArray<FString> FMetadataOps::FindAllMetaFilesInLibrary(const FString& LibraryRoot)
+{
+	TArray<FString> MetaFilepaths;
+	for (const FString& Directory : FVaultLibraryLayout::GetPackDirectories(LibraryRoot))
+	{
+		MetaFilepaths.Append(FindAllMetaFilesInFolder(Directory));
+	}
+	return MetaFilepaths;
+}
 
+TArray<FString> FMetadataOps::FindAllMetaFilesInFolder(const FString& PathToFolder)
+{
 	// Our custom file visitor that seeks out .meta files
 	class FFindMetaFilesVisitor : public IPlatformFile::FDirectoryVisitor
 	{
 	public:
 
 		FFindMetaFilesVisitor() {}
-		TArray<FString> MetaFilenames;
 		TArray<FString> MetaFilepaths;
 
 		virtual bool Visit(const TCHAR* FilenameOrDirectory, bool bIsDirectory)
@@ -78,7 +344,6 @@ TArray<FVaultMetadata> FMetadataOps::FindAllMetadataInFolder(FString PathToFolde
 
 				if (FPaths::GetExtension(VisitedFile) == TEXT("meta"))
 				{
-					MetaFilenames.Add(FPaths::GetBaseFilename(VisitedFile, true));
 					MetaFilepaths.Add(VisitedFile);
 				}
 			}
@@ -92,29 +357,90 @@ TArray<FVaultMetadata> FMetadataOps::FindAllMetadataInFolder(FString PathToFolde
 	// Iterate Dir. Visitor will populate with the info we need.
 	IFileManager::Get().IterateDirectory(*PathToFolder, Visitor);
 
-	// Loop through all meta files we found. Use simple for to have a index
-	for (int i = 0; i < Visitor.MetaFilenames.Num(); i++)
-	{
-		FString MetaRaw;
-		FFileHelper::LoadFileToString(MetaRaw, *Visitor.MetaFilepaths[i]);
+	// Directory listing order is up to the file system, sort so every caller sees the same order.
+	Visitor.MetaFilepaths.Sort();
 
-		TSharedPtr<FJsonObject> MetaJson = MakeShareable(new FJsonObject());
-		TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(MetaRaw);
+	return Visitor.MetaFilepaths;
+}
 
-		FJsonSerializer::Deserialize(JsonReader, MetaJson);
+TArray<FVaultMetadata> FMetadataOps::ReadMetadataFiles(const TArray<FString>& MetaFilepaths, bool bParallel, bool bHeaderOnly)
+{
+	TArray<FVaultMetadata> MetaList;
+	MetaList.SetNum(MetaFilepaths.Num());
 
-		//MetaList.Add(ParseMetaJsonToVaultMetadata(MetaJson));
-		MetaList.Add(ParseMetaJsonToVaultMetadata(MetaJson));
+	if (!bParallel || MetaFilepaths.Num() <= 1)
+	{
+		for (int32 FileIndex = 0; FileIndex < MetaFilepaths.Num(); FileIndex++)
+		{
+			MetaList[FileIndex] = ReadMetadata(MetaFilepaths[FileIndex], bHeaderOnly);
+		}
+		return MetaList;
 	}
 
+	// Each file read is a round trip to the share, so spread them over a fixed number of workers.
+	// Every worker takes a contiguous slice and writes into its own slots, which keeps the result in listing order.
+	const int32 NumWorkers = FMath::Min(FMath::Min(MaxIngestionWorkers, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1), MetaFilepaths.Num());
+	const int32 FilesPerWorker = FMath::DivideAndRoundUp(MetaFilepaths.Num(), NumWorkers);
+
+	ParallelFor(NumWorkers, [&MetaList, &MetaFilepaths, FilesPerWorker, bHeaderOnly](int32 WorkerIndex)
+	{
+		const int32 FirstFile = WorkerIndex * FilesPerWorker;
+		const int32 LastFile = FMath::Min(FirstFile + FilesPerWorker, MetaFilepaths.Num());
+
+		for (int32 FileIndex = FirstFile; FileIndex < LastFile; FileIndex++)
+		{
+			MetaList[FileIndex] = ReadMetadata(MetaFilepaths[FileIndex], bHeaderOnly);
+		}
+	});
+
 	return MetaList;
 }
 
+bool FMetadataOps::LoadDetails(FVaultMetadata& Metadata)
+{
+	if (Metadata.bDetailsLoaded)
+	{
+		return true;
+	}
+
+	{
+		FScopeLock Lock(&DetailsCacheLock);
+		if (const FVaultMetadataDetails* Cached = DetailsCache.FindAndTouch(Metadata.FileId))
+		{
+			if (Cached->LastModified == Metadata.LastModified)
+			{
+				Metadata.ObjectsInPack = Cached->ObjectsInPack;
+				Metadata.bDetailsLoaded = true;
+				return true;
+			}
+		}
+	}
+
+	const FString MetaFilepath = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), Metadata.FileId, TEXT("meta"));
+	const FVaultMetadata FullMetadata = ReadMetadata(MetaFilepath);
+
+	if (FullMetadata.FileId != Metadata.FileId)
+	{
+		UE_LOG(LogVault, Warning, TEXT("Could not load the details of %s from %s"), *Metadata.PackName.ToString(), *MetaFilepath);
+		return false;
+	}
+
+	Metadata.ObjectsInPack = FullMetadata.ObjectsInPack;
+	Metadata.bDetailsLoaded = true;
+
+	FVaultMetadataDetails Details;
+	Details.LastModified = FullMetadata.LastModified;
+	Details.ObjectsInPack = FullMetadata.ObjectsInPack;
+
+	FScopeLock Lock(&DetailsCacheLock);
+	DetailsCache.Add(Metadata.FileId, MoveTemp(Details));
+	return true;
+}
+
 bool FMetadataOps::CopyMetadataToLocal(FVaultMetadata& Metadata)
 {
-	const FString SrcDirectory = FVaultSettings::Get().GetAssetLibraryRoot();
 	const FString TgtDirectory = FVaultSettings::Get().GetProjectVaultFolder();
-	const FString SrcMetaFilepath = SrcDirectory / Metadata.FileId.ToString() + ".meta";
+	const FString SrcMetaFilepath = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), Metadata.FileId, TEXT("meta"));
 	const FString TgtMetaFilepath = TgtDirectory / Metadata.FileId.ToString() + ".meta";
 
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
@@ -127,6 +453,198 @@ bool FMetadataOps::CopyMetadataToLocal(FVaultMetadata& Metadata)
 	return PlatformFile.CopyFile(*TgtMetaFilepath, *SrcMetaFilepath, EPlatformFileRead::AllowWrite, EPlatformFileWrite::AllowRead);
 }
 
+bool FMetadataOps::ReadMetadataFromJson(const FString& Json, FVaultMetadata& OutMetadata, bool bHeaderOnly)
+{
+	// Start from a blank record, so nothing read into OutMetadata earlier survives a field the json lacks.
+	// Then match what the FJsonObject path gives for missing fields.
+	OutMetadata = FVaultMetadata();
+	OutMetadata.CreationDate = FDateTime();
+	OutMetadata.LastModified = FDateTime();
+	OutMetadata.HierarchyBadness = 0;
+	OutMetadata.bDetailsLoaded = !bHeaderOnly;
+
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+	{
+		return false;
+	}
+
+	// Nested objects and arrays we don't know are skipped whole, so the next ObjectEnd is always the end of the metadata.
+	while (Reader->ReadNext(Notation))
+	{
+		const FString& Field = Reader->GetIdentifier();
+
+		switch (Notation)
+		{
+		case EJsonNotation::ObjectEnd:
+			return true;
+
+		case EJsonNotation::String:
+		{
+			const FString& Value = Reader->GetValueAsString();
+
+			if (Field == TEXT("Author"))
+			{
+				OutMetadata.Author = FName(*Value);
+			}
+			else if (Field == TEXT("PackName"))
+			{
+				OutMetadata.PackName = FName(*Value);
+			}
+			else if (Field == TEXT("FileId"))
+			{
+				OutMetadata.FileId = FName(*Value);
+			}
+			else if (Field == TEXT("Description"))
+			{
+				OutMetadata.Description = Value;
+			}
+			else if (Field == TEXT("Category"))
+			{
+				OutMetadata.Category = FVaultMetadata::StringToCategory(Value);
+			}
+			else if (Field == TEXT("CreationDate"))
+			{
+				FDateTime::Parse(Value, OutMetadata.CreationDate);
+			}
+			else if (Field == TEXT("LastModified"))
+			{
+				FDateTime::Parse(Value, OutMetadata.LastModified);
+			}
+			else if (Field == TEXT("MachineID"))
+			{
+				OutMetadata.MachineID = Value;
+			}
+			break;
+		}
+
+		case EJsonNotation::Number:
+			if (Field == TEXT("HierarchyBadness"))
+			{
+				OutMetadata.HierarchyBadness = static_cast<int32>(Reader->GetValueAsNumber());
+			}
+			break;
+
+		case EJsonNotation::ArrayStart:
+		{
+			TSet<FString>* Target = nullptr;
+			if (Field == TEXT("Tags"))
+			{
+				Target = &OutMetadata.Tags;
+			}
+			else if (Field == TEXT("ObjectsInPack") && !bHeaderOnly)
+			{
+				Target = &OutMetadata.ObjectsInPack;
+			}
+
+			if (!Target)
+			{
+				if (!Reader->SkipArray())
+				{
+					return false;
+				}
+				break;
+			}
+
+			// Anything in the list that isn't a string is skipped, a broken one fails the whole record.
+			Target->Reset();
+			for (;;)
+			{
+				if (!Reader->ReadNext(Notation) || Notation == EJsonNotation::Error)
+				{
+					return false;
+				}
+
+				if (Notation == EJsonNotation::ArrayEnd)
+				{
+					break;
+				}
+
+				if (Notation == EJsonNotation::String)
+				{
+					Target->Add(Reader->GetValueAsString());
+				}
+				else if (Notation == EJsonNotation::ObjectStart && !Reader->SkipObject())
+				{
+					return false;
+				}
+				else if (Notation == EJsonNotation::ArrayStart && !Reader->SkipArray())
+				{
+					return false;
+				}
+			}
+			break;
+		}
+
+		case EJsonNotation::ObjectStart:
+			if (!Reader->SkipObject())
+			{
+				return false;
+			}
+			break;
+
+		case EJsonNotation::Error:
+			return false;
+
+		default:
+			break;
+		}
+	}
+
+	// Ran out of tokens before the closing brace.
+	return false;
+}
+
+FString FMetadataOps::WriteMetadataToJson(const FVaultMetadata& Metadata)
+{
+	FString OutputString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+
+	Writer->WriteObjectStart();
+
+	// User Info
+	Writer->WriteValue(TEXT("Author"), Metadata.Author.ToString());
+	Writer->WriteValue(TEXT("PackName"), Metadata.PackName.ToString());
+	Writer->WriteValue(TEXT("FileId"), Metadata.FileId.ToString());
+	Writer->WriteValue(TEXT("Description"), Metadata.Description);
+
+	// Category
+	Writer->WriteValue(TEXT("Category"), FVaultMetadata::CategoryToString(Metadata.Category));
+
+	// Tags
+	Writer->WriteArrayStart(TEXT("Tags"));
+	for (const FString& TagText : Metadata.Tags)
+	{
+		Writer->WriteValue(TagText);
+	}
+	Writer->WriteArrayEnd();
+
+	// Dates
+	Writer->WriteValue(TEXT("CreationDate"), Metadata.CreationDate.ToString());
+	Writer->WriteValue(TEXT("LastModified"), Metadata.LastModified.ToString());
+
+	// Sys info
+	Writer->WriteValue(TEXT("MachineID"), Metadata.MachineID);
+
+	// Hierarchy Badness. Written as a double, like FJsonValueNumber does.
+	Writer->WriteValue(TEXT("HierarchyBadness"), static_cast<double>(Metadata.HierarchyBadness));
+
+	// Objects
+	Writer->WriteArrayStart(TEXT("ObjectsInPack"));
+	for (const FString& ObjectText : Metadata.ObjectsInPack)
+	{
+		Writer->WriteValue(ObjectText);
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	return OutputString;
+}
+
 FVaultMetadata FMetadataOps::ParseMetaJsonToVaultMetadata(TSharedPtr<FJsonObject> MetaFile)
 {
 	// New blank metadata struct
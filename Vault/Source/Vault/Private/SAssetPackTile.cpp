@@ -35,7 +35,7 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 {
 	AssetItem = InArgs._AssetItem;
 
-	TSharedRef<SWidget> ThumbnailWidget = CreateTileThumbnail(AssetItem);
+	TSharedRef<SWidget> ThumbnailWidget = CreateTileThumbnail(AssetItem->GetMetadata());
 		
 	// Clear Old
 	this->ChildSlot [ SNullWidget::NullWidget ];
@@ -74,19 +74,19 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 				.Justification(ETextJustify::Right)
 				.ToolTipText_Lambda([this]
 					{
-						if (AssetItem->InProjectVersion == -1)
+						if (AssetItem->GetMetadata().InProjectVersion == -1)
 						{
 							return FText::FromString(TEXT("There is a newer version available than the one imported in this project."));
 						}
-						else if (AssetItem->InProjectVersion == -2)
+						else if (AssetItem->GetMetadata().InProjectVersion == -2)
 						{
 							return FText::FromString(TEXT("The asset could also not be found within the project, it was either moved or deleted.\nThere also is a newer version available than the one that was imported in this project."));
 						}
-						else if (AssetItem->InProjectVersion == 1)
+						else if (AssetItem->GetMetadata().InProjectVersion == 1)
 						{
 							return FText::FromString(TEXT("Imported Asset is up to data (or newer)."));
 						}
-						else if (AssetItem->InProjectVersion == 2)
+						else if (AssetItem->GetMetadata().InProjectVersion == 2)
 						{
 							return FText::FromString(TEXT("Asset has been moved or deleted in the project.\nBut the imported version is still up to data."));
 						}
@@ -97,7 +97,7 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 					})
 				.Visibility_Lambda([this]
 					{
-						if (AssetItem->InProjectVersion == -1 || AssetItem->InProjectVersion >= 1)
+						if (AssetItem->GetMetadata().InProjectVersion == -1 || AssetItem->GetMetadata().InProjectVersion >= 1)
 						{
 							return EVisibility::Visible;
 						}
@@ -108,20 +108,20 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 					})
 				.Text_Lambda([this]
 					{
-						if (AssetItem->InProjectVersion == -1)
+						if (AssetItem->GetMetadata().InProjectVersion == -1)
 						{
 							return FEditorFontGlyphs::Info;
 						}
-						else if (AssetItem->InProjectVersion == -2)
+						else if (AssetItem->GetMetadata().InProjectVersion == -2)
 						{
 							return FEditorFontGlyphs::Question;
 						}
-						else if (AssetItem->InProjectVersion == 1)
+						else if (AssetItem->GetMetadata().InProjectVersion == 1)
 						{
 							return FEditorFontGlyphs::Check;
 						}
 
-						else if (AssetItem->InProjectVersion == 2)
+						else if (AssetItem->GetMetadata().InProjectVersion == 2)
 						{
 							return FEditorFontGlyphs::Question;
 						}
@@ -132,19 +132,19 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 					})
 				.ColorAndOpacity_Lambda([this]
 					{
-						if (AssetItem->InProjectVersion == -1)
+						if (AssetItem->GetMetadata().InProjectVersion == -1)
 						{
 							return FLinearColor::Yellow;
 						}
-						else if (AssetItem->InProjectVersion == -2)
+						else if (AssetItem->GetMetadata().InProjectVersion == -2)
 						{
 							return FLinearColor::Gray;
 						}
-						else if (AssetItem->InProjectVersion == 1)
+						else if (AssetItem->GetMetadata().InProjectVersion == 1)
 						{
 							return FLinearColor::Green;
 						}
-						else if (AssetItem->InProjectVersion == 2)
+						else if (AssetItem->GetMetadata().InProjectVersion == 2)
 						{
 							return FLinearColor::Gray;
 						}
@@ -168,7 +168,7 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 			[
 				SAssignNew(InlineRenameWidget, SInlineEditableTextBlock)
 				.Font(FEditorStyle::GetFontStyle("ContentBrowser.AssetTileViewNameFont"))
-				.Text(FText::FromName(InArgs._AssetItem->PackName.IsNone() ? TEXT("Unknown Pack") : AssetItem->PackName))
+				.Text(FText::FromName(AssetItem->GetMetadata().PackName.IsNone() ? TEXT("Unknown Pack") : AssetItem->GetMetadata().PackName))
 				.WrapTextAt(300)
 				.OnBeginTextEdit(this, &SAssetTileItem::HandleBeginNameChange)
 				.OnTextCommitted(this, &SAssetTileItem::HandleNameCommitted)
@@ -189,7 +189,7 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 				.Justification(ETextJustify::Right)
 				.ToolTipText_Lambda([this]
 					{
-						switch (AssetItem->HierarchyBadness)
+						switch (AssetItem->GetMetadata().HierarchyBadness)
 						{
 						case 0:
 							return FText::FromString(TEXT("Asset has good hierarchy!"));
@@ -213,7 +213,7 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 					})
 				.Visibility_Lambda([this]
 					{
-						if (AssetItem->HierarchyBadness == 0)
+						if (AssetItem->GetMetadata().HierarchyBadness == 0)
 						{
 							return EVisibility::Collapsed;
 						}
@@ -228,11 +228,11 @@ void SAssetTileItem::Construct(const FArguments& InArgs)
 					})
 				.ColorAndOpacity_Lambda([this]
 					{
-						if (AssetItem->HierarchyBadness == 0)
+						if (AssetItem->GetMetadata().HierarchyBadness == 0)
 						{
 							return FLinearColor::Green;
 						}
-						else if (AssetItem->HierarchyBadness > 0 && AssetItem->HierarchyBadness < 3)
+						else if (AssetItem->GetMetadata().HierarchyBadness > 0 && AssetItem->GetMetadata().HierarchyBadness < 3)
 						{
 							return FLinearColor::Yellow;
 						}
@@ -273,10 +273,10 @@ void SAssetTileItem::Tick(const FGeometry& AllottedGeometry, const double InCurr
 	}
 }
 
-TSharedRef<SWidget> SAssetTileItem::CreateTileThumbnail(TSharedPtr<FVaultMetadata> Meta)
+TSharedRef<SWidget> SAssetTileItem::CreateTileThumbnail(const FVaultMetadata& Meta)
 {
 	const FString Root = FVaultSettings::Get().GetThumbnailCacheRoot();
-	const FString FileId = Meta->FileId.ToString();
+	const FString FileId = Meta.FileId.ToString();
 	const FString Filepath = Root / FileId + TEXT(".png");
 
 	if (FPaths::FileExists(Filepath) == false)
@@ -317,19 +317,26 @@ void SAssetTileItem::HandleBeginNameChange(const FText& OriginalText)
 
 void SAssetTileItem::HandleNameCommitted(const FText& NewText, ETextCommit::Type CommitInfo)
 {
+	// The .meta file gets rewritten, so we need the full record. The snapshot only holds the header.
+	FVaultMetadata AssetMeta = AssetItem->GetMetadata();
+	if (!FMetadataOps::LoadDetails(AssetMeta))
+	{
+		return;
+	}
+
 	FVaultMetadata RenameMetaData;
 
-	RenameMetaData.Author = AssetItem->Author;
-	RenameMetaData.PackName = AssetItem->PackName;
-	RenameMetaData.FileId = AssetItem->FileId;
-	RenameMetaData.Description = AssetItem->Description;
-	RenameMetaData.CreationDate = AssetItem->CreationDate;
+	RenameMetaData.Author = AssetMeta.Author;
+	RenameMetaData.PackName = AssetMeta.PackName;
+	RenameMetaData.FileId = AssetMeta.FileId;
+	RenameMetaData.Description = AssetMeta.Description;
+	RenameMetaData.CreationDate = AssetMeta.CreationDate;
 	RenameMetaData.LastModified = FDateTime::UtcNow();
-	RenameMetaData.Tags = AssetItem->Tags;
-	RenameMetaData.Category = AssetItem->Category;
-	RenameMetaData.MachineID = AssetItem->MachineID;
-	RenameMetaData.HierarchyBadness = AssetItem->HierarchyBadness;
-	RenameMetaData.ObjectsInPack = AssetItem->ObjectsInPack;
+	RenameMetaData.Tags = AssetMeta.Tags;
+	RenameMetaData.Category = AssetMeta.Category;
+	RenameMetaData.MachineID = AssetMeta.MachineID;
+	RenameMetaData.HierarchyBadness = AssetMeta.HierarchyBadness;
+	RenameMetaData.ObjectsInPack = AssetMeta.ObjectsInPack;
 
 	if (UAssetPublisher::RenamePackage(FName(NewText.ToString()), RenameMetaData))
 	{
@@ -339,7 +346,7 @@ void SAssetTileItem::HandleNameCommitted(const FText& NewText, ETextCommit::Type
 
 bool SAssetTileItem::HandleVerifyNameChanged(const FText& NewText, FText& OutErrorMessage)
 {
-	if (AssetItem->PackName != FName(*NewText.ToString()) && UAssetPublisher::FindMetadataByPackName(FName(*NewText.ToString())).IsMetaValid())
+	if (AssetItem->GetMetadata().PackName != FName(*NewText.ToString()) && UAssetPublisher::IsPackNameInUse(FName(*NewText.ToString())))
 	{
 		InlineRenameWidget->SetColorAndOpacity(FLinearColor::Red);
 	}
@@ -4,7 +4,13 @@
 
 #include "Vault.h"
 #include "VaultSettings.h"
+#include "VaultConnectionMonitor.h"
+#include "VaultLibraryLayout.h"
 #include "MetadataOps.h"
+#include "VaultLibraryIndex.h"
+#include "VaultLibraryJournal.h"
+#include "VaultStringDictionary.h"
+#include "VaultLoaderSearch.h"
 #include "SAssetPackTile.h"
 #include "VaultStyle.h"
 #include "AssetPublisher.h"
@@ -24,6 +30,7 @@
 #include "Kismet/KismetStringLibrary.h"
 
 #include "Widgets/Layout/SScalebox.h"
+#include "Widgets/Images/SThrobber.h"
 
 #include "EditorAssetLibrary.h"
 
@@ -120,7 +127,7 @@ public:
 	void OnCheckBoxStateChanged(ECheckBoxState NewCheckedState)
 	{
 		const bool Filter = NewCheckedState == ECheckBoxState::Checked;
-		ParentWindow->ModifyActiveTagFilters(TagData->Tag, Filter);
+		ParentWindow->ModifyActiveTagFilters(TagData->TagId, Filter);
 	}
 
 
@@ -217,7 +224,9 @@ private:
 
 void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTab>& ConstructUnderMajorTab, const TSharedPtr<SWindow>& ConstructUnderWindow)
 {
+	// Show whatever the library looked like last time straight away, the refresh below swaps in the current state when it is done.
 	RefreshAvailableFiles();
+	CacheLibraryItems();
 	PopulateBaseAssetList();
 	PopulateCategoryArray();
 	PopulateTagArray();
@@ -231,13 +240,14 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 
 	SortFilteredAssets(ActiveSortingType, bSortingReversed);
 
-	LastSearchTextLength = 0;
-
 	// Bind to our publisher so we can refresh automatically when the user publishes an asset (they wont need to import it, but its a visual feedback for the user to check it appeared in the library
 	UAssetPublisher::OnVaultPackagingCompletedDelegate.BindRaw(this, &SLoaderWindow::OnAssetUpdateHappened);
 
 	// Bind to vault module update delegate to automatically refresh when an asset was updated
 	FVaultModule::Get().OnAssetWasUpdated.BindRaw(this, &SLoaderWindow::OnAssetUpdateHappened);
+
+	// Packs published or changed by other users are picked up by the library watcher, we only need to redraw.
+	FVaultModule::Get().OnLibrarySnapshotPublished.AddSP(this, &SLoaderWindow::RefreshLibraryViews);
 	
 	// Construct the Holder for the Metadata List
 	MetadataWidget = SNew(SVerticalBox);
@@ -389,8 +399,8 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 								.OnTextCommitted(this, &SLoaderWindow::OnSearchBoxCommitted)
 								.DelayChangeNotificationsWhileTyping(false)
 								.Visibility(EVisibility::Visible)
-								.IsEnabled_Lambda([this] {
-									return IsConnected;
+								.IsEnabled_Lambda([] {
+									return FVaultConnectionMonitor::Get().IsReachable();
 								})
 								.AddMetaData<FTagMetaData>(FTagMetaData(TEXT("AssetSearch")))
 							]
@@ -415,6 +425,30 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 								]
 							]
 
+							+ SHorizontalBox::Slot()
+							.Padding(FMargin(5.f,0.f, 5.f, 0.f))
+							.AutoWidth()
+							[
+								SAssignNew(FuzzySearchCheckBox, SCheckBox)
+								.Style(FCoreStyle::Get(), "ToggleButtonCheckbox")
+								.Padding(FMargin( 5.f,0.f ))
+								.ToolTipText(LOCTEXT("FuzzySearchToolTip", "Tolerate typos, and list the best matches first instead of by the sort order"))
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState)
+								{
+									OnSearchBoxChanged(SearchBox->GetText());
+								})
+								[
+									SNew(SBox)
+									.VAlign(VAlign_Center)
+									.HAlign(HAlign_Center)
+									.Padding(FMargin(4.f,2.f))
+									[
+										SNew(STextBlock)
+										.Text(LOCTEXT("FuzzySearchCheckBox", "Fuzzy Search"))
+									]
+								]
+							]
+
 							+ SHorizontalBox::Slot()
 							.Padding(FMargin(5.f, 0.f, 5.f, 0.f))
 							.AutoWidth()
@@ -436,6 +470,20 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 								]
 							]
 
+							// Shown while the library is being rescanned in the background
+							+ SHorizontalBox::Slot()
+							.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
+							.VAlign(VAlign_Center)
+							.AutoWidth()
+							[
+								SNew(SThrobber)
+								.ToolTipText(LOCTEXT("RefreshingLibraryToolTip", "Refreshing library..."))
+								.Visibility_Lambda([]()
+								{
+									return FVaultModule::Get().IsLibraryRefreshing() ? EVisibility::Visible : EVisibility::Collapsed;
+								})
+							]
+
 							+ SHorizontalBox::Slot()
 							.Padding(FMargin(5.f, 0.f, 5.f, 0.f))
 							.AutoWidth()
@@ -475,9 +523,9 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 									.BackgroundColor(FLinearColor::Black)
 									.ForegroundColor(FLinearColor::Red)
 									.Text(LOCTEXT("VaultFailedConnection", "Couldn't connect to vault folder!\nCheck if the location set in your local settings file is reachable."))
-									.Visibility_Lambda([this]
+									.Visibility_Lambda([]
 									{
-										if (IsConnected)
+										if (FVaultConnectionMonitor::Get().IsReachable())
 										{
 											return EVisibility::Collapsed;
 										}
@@ -496,7 +544,7 @@ void SLoaderWindow::Construct(const FArguments& InArgs, const TSharedRef<SDockTa
 								SNew(SBox)
 								.Padding(FMargin(5,5,5,5))
 								[
-									SAssignNew(TileView, STileView<TSharedPtr<FVaultMetadata>>)
+									SAssignNew(TileView, STileView<TSharedPtr<FVaultLibraryItem>>)
 									.ItemWidth(TILE_SCALED_WIDTH)
 									.ItemHeight(TILE_SCALED_HEIGHT)
 									.ItemAlignment(EListItemAlignment::EvenlyDistributed)
@@ -596,14 +644,54 @@ void SLoaderWindow::Tick(const FGeometry& AllottedGeometry, const double InCurre
 
 }
 
+void SLoaderWindow::CacheLibraryItems()
+{
+	const FVaultLibrarySnapshotPtr Library = FVaultModule::Get().GetLibrarySnapshot();
+	if (Library == DisplayedLibrary)
+	{
+		return;
+	}
+
+	CancelSearch();
+	CompletedSearchText.Reset();
+	DisplayedLibrary = Library;
+
+	// Row items point into the snapshot and are made the first time a row passes the filters, see GetLibraryItem.
+	LibraryItems.Reset();
+	LibraryItems.SetNum(Library.IsValid() ? Library->Assets.Num() : 0);
+	FilteredRows.Reset();
+}
+
+TSharedPtr<FVaultLibraryItem> SLoaderWindow::GetLibraryItem(int32 Row)
+{
+	TSharedPtr<FVaultLibraryItem>& Item = LibraryItems[Row];
+	if (!Item.IsValid())
+	{
+		Item = MakeShared<FVaultLibraryItem>(DisplayedLibrary, Row);
+	}
+	return Item;
+}
+
+void SLoaderWindow::UpdateFilteredAssetItems()
+{
+	FilteredAssetItems.Reset(FilteredRows.Num());
+	for (const int32 Row : FilteredRows)
+	{
+		FilteredAssetItems.Add(GetLibraryItem(Row));
+	}
+}
+
 void SLoaderWindow::PopulateBaseAssetList()
 {
-	FilteredAssetItems.Empty();
+	const int32 NumRows = DisplayedLibrary.IsValid() ? DisplayedLibrary->Catalog->Num() : 0;
 
-	for (FVaultMetadata Meta : FVaultModule::Get().MetaFilesCache)
+	FilteredRows.Reset(NumRows);
+	for (int32 Row = 0; Row < NumRows; Row++)
 	{
-		FilteredAssetItems.Add(MakeShareable(new FVaultMetadata(Meta)));
+		FilteredRows.Add(Row);
 	}
+	FilterRows.Init(NumRows, true);
+	UpdateFilteredAssetItems();
 }
 
 // Show all categories, even if they are unused
@@ -624,15 +712,19 @@ void SLoaderWindow::PopulateCategoryArray()
 		CategoryCloudMap.Add(CurCat, CatTemp);
 	}
 
-	for (auto Asset : FVaultModule::Get().MetaFilesCache)
+	if (DisplayedLibrary.IsValid())
 	{
-		if (Asset.IsMetaValid() && CategoryCloudMap.Contains(Asset.Category))
-		{
-			CategoryCloudMap.Find(Asset.Category)->Get()->UseCount++;
-		}
-		else
+		for (const uint8 AssetCategory : DisplayedLibrary->Catalog->Categories)
 		{
-			CategoryCloudMap.Find(FVaultCategory::Unknown)->Get()->UseCount++;
+			const FVaultCategory Category = static_cast<FVaultCategory>(AssetCategory);
+			if (CategoryCloudMap.Contains(Category))
+			{
+				CategoryCloudMap.Find(Category)->Get()->UseCount++;
+			}
+			else
+			{
+				CategoryCloudMap.Find(FVaultCategory::Unknown)->Get()->UseCount++;
+			}
 		}
 	}
 
@@ -646,41 +738,40 @@ void SLoaderWindow::PopulateTagArray()
 	// Empty Tag Container
 	TagCloud.Empty();
 
-	// Create a map version of the array for more efficient searching.
-	TMap<FString, FTagFilteringItemPtr> TagCloudMap;
+	// Tag ids are dense, so counting is a plain array lookup per tag.
+	const FVaultStringDictionary& TagDictionary = FVaultStringDictionary::Tags();
+	TArray<int32> TagUseCounts;
+	TagUseCounts.SetNumZeroed(TagDictionary.Num());
 
-	// For each Asset in our global list of assets...
-	for (auto Asset : FVaultModule::Get().MetaFilesCache)
+	// Every tag of every asset in the library, and increment its use counter
+	if (DisplayedLibrary.IsValid())
 	{
-		// Get each tag belonging to that asset...
-		for (const FString AssetTag : Asset.Tags)
+		for (const int32 TagId : DisplayedLibrary->Catalog->TagIds)
 		{
-			// If we already have a tag stored for it, increment the use counter
-			if (TagCloudMap.Contains(AssetTag))
+			if (TagUseCounts.IsValidIndex(TagId))
 			{
-				TagCloudMap.Find(AssetTag)->Get()->UseCount++;
+				TagUseCounts[TagId]++;
 			}
+		}
+	}
 
-			// otherwise, add a new tag to our list. 
-			else
-			{
-
-				FTagFilteringItemPtr TagTemp = MakeShareable(new FTagFilteringItem);
-				TagTemp->Tag = AssetTag;
-				TagTemp->UseCount = 1;
-				TagCloudMap.Add(AssetTag, TagTemp);
-			}
+	for (int32 TagId = 0; TagId < TagUseCounts.Num(); TagId++)
+	{
+		if (TagUseCounts[TagId] > 0)
+		{
+			FTagFilteringItemPtr TagTemp = MakeShareable(new FTagFilteringItem);
+			TagTemp->Tag = TagDictionary.GetString(TagId);
+			TagTemp->TagId = TagId;
+			TagTemp->UseCount = TagUseCounts[TagId];
+			TagCloud.Add(TagTemp);
 		}
 	}
 
-	TagCloudMap.KeySort([](const FString& A, const FString& B) 
+	TagCloud.Sort([](const FTagFilteringItemPtr& A, const FTagFilteringItemPtr& B)
 		{
-			return A < B;
+			return A->Tag < B->Tag;
 		});
 
-	// The Map version is easier to work with during generation, but since we have to use an Array, we convert our cloud map into an array now:
-	TagCloudMap.GenerateValueArray(TagCloud);
-
 }
 
 void SLoaderWindow::PopulateDeveloperNameArray()
@@ -688,34 +779,25 @@ void SLoaderWindow::PopulateDeveloperNameArray()
 	// Developer Array
 	DeveloperCloud.Empty();
 
-	TMap<FName, int32> DevAssetCounter;
+	TMap<int32, int32> DevAssetCounter;
 
-	for (auto AssetItem : FilteredAssetItems)
+	for (const int32 Row : FilteredRows)
 	{
-		if (DevAssetCounter.Contains(AssetItem->Author))
-		{
-			int Count = *DevAssetCounter.Find(AssetItem->Author);
-			Count++;
-			DevAssetCounter.Add(AssetItem->Author, Count);
-		}
-		else
-		{
-			DevAssetCounter.Add(AssetItem->Author, 1);
-		}
+		DevAssetCounter.FindOrAdd(DisplayedLibrary->Catalog->AuthorIds[Row])++;
 	}
 
 	for (auto dev : DevAssetCounter)
 	{
 		FDeveloperFilteringItemPtr DevTemp = MakeShareable(new FDeveloperFilteringItem);
-		DevTemp->Developer = dev.Key;
+		DevTemp->Developer = FName(*FVaultStringDictionary::Authors().GetString(dev.Key));
 		DevTemp->UseCount = dev.Value;
 		DeveloperCloud.AddUnique(DevTemp);
 	}
 }
 
-TSharedRef<ITableRow> SLoaderWindow::MakeTileViewWidget(TSharedPtr<FVaultMetadata> AssetItem, const TSharedRef<STableViewBase>& OwnerTable)
+TSharedRef<ITableRow> SLoaderWindow::MakeTileViewWidget(TSharedPtr<FVaultLibraryItem> AssetItem, const TSharedRef<STableViewBase>& OwnerTable)
 {
-	return SNew(STableRow<TSharedPtr<FVaultMetadata>>, OwnerTable)
+	return SNew(STableRow<TSharedPtr<FVaultLibraryItem>>, OwnerTable)
 		.Style(FEditorStyle::Get(), "ContentBrowser.AssetListView.TableRow")
 		.Padding(FMargin(5.0f, 5.0f, 5.0f, 25.0f))
 		[
@@ -746,7 +828,7 @@ TSharedRef<ITableRow> SLoaderWindow::MakeDeveloperFilterViewWidget(FDeveloperFil
 		.ParentWindow(SharedThis(this));
 }
 
-void SLoaderWindow::OnAssetTileSelectionChanged(TSharedPtr<FVaultMetadata> InItem, ESelectInfo::Type SelectInfo)
+void SLoaderWindow::OnAssetTileSelectionChanged(TSharedPtr<FVaultLibraryItem> InItem, ESelectInfo::Type SelectInfo)
 {
 	// Checks if anything is selected
 	if (TileView->GetNumItemsSelected() > 0)
@@ -760,7 +842,7 @@ void SLoaderWindow::OnAssetTileSelectionChanged(TSharedPtr<FVaultMetadata> InIte
 
 }
 
-void SLoaderWindow::OnAssetTileDoubleClicked(TSharedPtr<FVaultMetadata> InItem)
+void SLoaderWindow::OnAssetTileDoubleClicked(TSharedPtr<FVaultLibraryItem> InItem)
 {
 	// #todo Add Item to Project on Double Click
 	LoadAssetPackIntoProject(InItem);
@@ -777,7 +859,7 @@ TSharedPtr<SWidget> SLoaderWindow::OnAssetTileContextMenuOpened()
 	}
 	
 	// Store our selected item for any future operations.
-	TSharedPtr<FVaultMetadata> SelectedAsset = TileView->GetSelectedItems()[0];
+	TSharedPtr<FVaultLibraryItem> SelectedAsset = TileView->GetSelectedItems()[0];
 
 	FMenuBuilder MenuBuilder(true, nullptr, nullptr, true);
 
@@ -809,22 +891,23 @@ TSharedPtr<SWidget> SLoaderWindow::OnAssetTileContextMenuOpened()
 				{
 					// On Asset Publisher prefilled to update an asset
 
-					if (SelectedAsset->IsMetaValid())
+					FVaultMetadata SelectedMeta = SelectedAsset->GetMetadata();
+					if (SelectedMeta.IsMetaValid() && FMetadataOps::LoadDetails(SelectedMeta))
 					{
 						FVaultModule::Get().VaultBasePanelWidget->SetActiveSubTab("Asset Publisher");
 
 						FVaultMetadata AssetPublishMetadata;
 
-						AssetPublishMetadata.Author = SelectedAsset->Author;
-						AssetPublishMetadata.PackName = SelectedAsset->PackName;
-						AssetPublishMetadata.FileId = SelectedAsset->FileId;
-						AssetPublishMetadata.Description = SelectedAsset->Description;
-						AssetPublishMetadata.CreationDate = SelectedAsset->CreationDate;
+						AssetPublishMetadata.Author = SelectedMeta.Author;
+						AssetPublishMetadata.PackName = SelectedMeta.PackName;
+						AssetPublishMetadata.FileId = SelectedMeta.FileId;
+						AssetPublishMetadata.Description = SelectedMeta.Description;
+						AssetPublishMetadata.CreationDate = SelectedMeta.CreationDate;
 						AssetPublishMetadata.LastModified = FDateTime::UtcNow();
-						AssetPublishMetadata.Tags = SelectedAsset->Tags;
-						AssetPublishMetadata.Category = SelectedAsset->Category;
-						AssetPublishMetadata.HierarchyBadness = SelectedAsset->HierarchyBadness;
-						AssetPublishMetadata.ObjectsInPack = SelectedAsset->ObjectsInPack;
+						AssetPublishMetadata.Tags = SelectedMeta.Tags;
+						AssetPublishMetadata.Category = SelectedMeta.Category;
+						AssetPublishMetadata.HierarchyBadness = SelectedMeta.HierarchyBadness;
+						AssetPublishMetadata.ObjectsInPack = SelectedMeta.ObjectsInPack;
 
 						FVaultModule::Get().OnAssetForUpdateChosen.ExecuteIfBound(AssetPublishMetadata);
 					}
@@ -852,7 +935,7 @@ TSharedPtr<SWidget> SLoaderWindow::OnAssetTileContextMenuOpened()
 			FUIAction(FExecuteAction::CreateLambda([this, SelectedAsset]()
 				{
 					const FString LibraryPath = FVaultSettings::Get().GetAssetLibraryRoot();
-					const FString MetaFilePath = LibraryPath / SelectedAsset->FileId.ToString() + ".meta";
+					const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(LibraryPath, SelectedAsset->GetMetadata().FileId, TEXT("meta"));
 
 					const FText WarningMsg = LOCTEXT("EditAssetMetadataMsg", "Do you really want to manually edit this assets metadata?\nOnly continue if you know what you are doing.");
 					const FText WarningTitle = LOCTEXT("EditAssetMetadataTitle", "Attempting to edit Metadata");
@@ -888,12 +971,12 @@ TSharedPtr<SWidget> SLoaderWindow::OnAssetTileContextMenuOpened()
 					FGetActionCheckState(),
 					FIsActionButtonVisible()));
 
-		if (SelectedAsset->InProjectVersion != 0)
+		if (SelectedAsset->GetMetadata().InProjectVersion != 0)
 		{
 			MenuBuilder.AddMenuEntry(LOCTEXT("ACM_DeleteLocalMetadataLabel", "Remove Metadata from Project"), LOCTEXT("ACM_DeleteLocalMetadataTooltip", "Delete Local Metadata of this asset that is added when importing an asset.\nThis will remove the indicator shown when the asset has been imported.\nCan be used when an imported asset has been removed from the project."), FSlateIcon(),
 				FUIAction(FExecuteAction::CreateLambda([this, SelectedAsset]()
 					{
-						FMetadataOps::DeleteMetadata(*SelectedAsset);
+						FMetadataOps::DeleteMetadata(SelectedAsset->GetMetadata());
 						RefreshLibrary();
 					}),
 					FCanExecuteAction(),
@@ -981,61 +1064,123 @@ TSharedRef<SWidget> SLoaderWindow::OnSortingOptionsMenuOpened()
 
 void SLoaderWindow::OnSearchBoxChanged(const FText& inSearchText)
 {
-	//FilteredAssetItems.Empty();
+	// Whatever is still searching for the old text is out of date now.
+	CancelSearch();
 
 	// If its now empty, it was probably cleared or backspaced through, so we need to reapply just the filter based results.
 	if (inSearchText.IsEmpty())
 	{
+		SearchBox->SetError(FText::GetEmpty());
 		UpdateFilteredAssets();
 		SortFilteredAssets();
 		return;
 	}
-	if (inSearchText.ToString().Len() < LastSearchTextLength)
+
+	if (!DisplayedLibrary.IsValid() || FilterRows.NumRows != DisplayedLibrary->Catalog->Num())
 	{
-		UpdateFilteredAssets();
+		return;
 	}
 
-	LastSearchTextLength = inSearchText.ToString().Len();
+	const FString SearchString = inSearchText.ToString();
 
 	// Store Strict Search - This controls if we only search pack name, or various data entries.
 	const bool bStrictSearch = StrictSearchCheckBox->GetCheckedState() == ECheckBoxState::Checked;
 
-	const FString SearchString = inSearchText.ToString();
-	
-	// Holder for the newly filtered Results:
-	TArray<TSharedPtr<FVaultMetadata>> SearchMatchingEntries;
+	// The search itself runs in the background, typing never waits for it.
+	FVaultLoaderSearch::FParams Params;
+	Params.Library = DisplayedLibrary;
+	Params.SearchText = SearchString;
+	Params.bNameOnly = bStrictSearch;
+	Params.AllowedRows = FilterRows;
+	Params.SortingType = ActiveSortingType;
+	Params.bSortReversed = bSortingReversed;
+
+	// Queries such as "tag:rock -tag:wip modified>2026-01-01" go through the query plan, plain words get the regular or fuzzy search.
+	if (FVaultLibraryQuery::IsStructured(SearchString))
+	{
+		// A new query rather than changing the old one, a cancelled search may not have let go of it yet.
+		if (!SearchQuery.IsValid() || !SearchQuery->IsSameQuery(SearchString, bStrictSearch))
+		{
+			SearchQuery = MakeShared<FVaultLibraryQuery, ESPMode::ThreadSafe>();
+			SearchQuery->SetQuery(SearchString, bStrictSearch);
+		}
+		SearchBox->SetError(SearchQuery->GetErrorText());
 
-	// Instead of searching raw meta, we search the filtered results, so this respects the tag and dev filters first, and we search within that.
-	for (auto Meta : FilteredAssetItems)
+		Params.Mode = FVaultLoaderSearch::EMode::Query;
+		Params.Query = SearchQuery;
+	}
+	else
 	{
-		if (Meta->PackName.ToString().Contains(SearchString))
+		SearchBox->SetError(FText::GetEmpty());
+
+		// Fuzzy results come ranked, best match first, rather than in the sort order.
+		Params.Mode = FuzzySearchCheckBox->IsChecked() ? FVaultLoaderSearch::EMode::Fuzzy : FVaultLoaderSearch::EMode::Plain;
+
+		// Typing on only narrows down the last results, which is all a search too short for the index has to go through.
+		if (Params.Mode == FVaultLoaderSearch::EMode::Plain && !CompletedSearchText.IsEmpty()
+			&& bCompletedSearchStrict == bStrictSearch && SearchString.Contains(CompletedSearchText))
 		{
-			SearchMatchingEntries.Add(Meta);
-			continue;
+			Params.bNarrowPrevious = true;
+			Params.PreviousRows = FilteredRows;
 		}
-		
-		if (bStrictSearch == false)
+	}
+
+	TWeakPtr<SLoaderWindow> WeakWindow = SharedThis(this);
+	bActiveSearchShown = false;
+	ActiveSearch = FVaultLoaderSearch::Start(MoveTemp(Params), [WeakWindow](const TArray<int32>& Rows, bool bFinished)
+	{
+		if (TSharedPtr<SLoaderWindow> Window = WeakWindow.Pin())
 		{
-			if (Meta->Author.ToString().Contains(SearchString) || Meta->Description.Contains(SearchString))
-			{
-				SearchMatchingEntries.Add(Meta);
-				continue;
-			}
-			for (FString tag : Meta->Tags)
-			{
-				if (tag.Contains(SearchString)) {
-					SearchMatchingEntries.Add(Meta);
-					break;
-				}
-			}
+			Window->OnSearchResults(Rows, bFinished);
 		}
+	});
+}
+
+void SLoaderWindow::CancelSearch()
+{
+	if (ActiveSearch.IsValid())
+	{
+		ActiveSearch->Cancel();
+		ActiveSearch.Reset();
 	}
+}
 
-	FilteredAssetItems = SearchMatchingEntries;
-	SortFilteredAssets();
-	TileView->RebuildList();
-	TileView->ScrollToTop();
+void SLoaderWindow::OnSearchResults(const TArray<int32>& Rows, bool bFinished)
+{
+	const FVaultLoaderSearch::FParams& Params = ActiveSearch->GetParams();
+
+	// The first batch replaces what the list showed, so it never flashes empty while typing.
+	// The rows of the last completed search are gone with it.
+	if (!bActiveSearchShown)
+	{
+		bActiveSearchShown = true;
+		CompletedSearchText.Reset();
+		FilteredRows.Reset();
+		FilteredAssetItems.Reset();
+		TileView->ScrollToTop();
+	}
+
+	FilteredRows.Append(Rows);
+	for (const int32 Row : Rows)
+	{
+		FilteredAssetItems.Add(GetLibraryItem(Row));
+	}
+
+	// Batches arrive in the sort order the search started with. If that has changed since, sort once all of them are in.
+	const bool bRanked = Params.Mode == FVaultLoaderSearch::EMode::Fuzzy;
+	if (bFinished && !bRanked && (Params.SortingType != ActiveSortingType || Params.bSortReversed != bSortingReversed))
+	{
+		SortFilteredAssets();
+	}
 
+	TileView->RequestListRefresh();
+
+	if (bFinished)
+	{
+		CompletedSearchText = Params.Mode == FVaultLoaderSearch::EMode::Plain ? Params.SearchText : FString();
+		bCompletedSearchStrict = Params.bNameOnly;
+		ActiveSearch.Reset();
+	}
 }
 
 void SLoaderWindow::OnSearchBoxCommitted(const FText& InFilterText, ETextCommit::Type CommitType)
@@ -1043,7 +1188,7 @@ void SLoaderWindow::OnSearchBoxCommitted(const FText& InFilterText, ETextCommit:
 	OnSearchBoxChanged(InFilterText);
 }
 
-void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta)
+void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultLibraryItem> AssetItem)
 {
 
 	// Safety Catches for Null Assets. Should never occur.
@@ -1053,12 +1198,16 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		return;
 	}
 
-	if (!AssetMeta.IsValid() || !AssetMeta->IsMetaValid())
+	if (!AssetItem.IsValid() || !AssetItem->GetMetadata().IsMetaValid())
 	{
 		UE_LOG(LogVault, Error, TEXT("Error - Metadata Incoming Data is Null."));
 		return;
 	}
 
+	// The snapshot only holds the header, the object list is loaded into a copy.
+	FVaultMetadata AssetMeta = AssetItem->GetMetadata();
+	FMetadataOps::LoadDetails(AssetMeta);
+
 	// Padding between words
 	const FMargin WordPadding = FMargin(0.f,12.f,0.f,0.f);
 
@@ -1070,7 +1219,7 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		.Padding(WordPadding)
 	[
 		SNew(STextBlock)
-			.Text(FText::FromName(AssetMeta->PackName))
+			.Text(FText::FromName(AssetMeta.PackName))
 	];
 
 	// Description
@@ -1081,8 +1230,8 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		[
 			SNew(STextBlock)
 			.AutoWrapText(true)
-			//.Text(FText::Format(LOCTEXT("Meta_DescLbl", "Description: \n{0}"), FText::FromString(AssetMeta->Description)))
-			.Text(FText::FromString(AssetMeta->Description))
+			//.Text(FText::Format(LOCTEXT("Meta_DescLbl", "Description: \n{0}"), FText::FromString(AssetMeta.Description)))
+			.Text(FText::FromString(AssetMeta.Description))
 		];
 
 	// Author
@@ -1091,7 +1240,7 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		.Padding(WordPadding)
 		[
 			SNew(STextBlock)
-			.Text(FText::Format(LOCTEXT("Meta_AuthorLbl", "Author: {0}"), FText::FromName(AssetMeta->Author)))
+			.Text(FText::Format(LOCTEXT("Meta_AuthorLbl", "Author: {0}"), FText::FromName(AssetMeta.Author)))
 		];
 
 
@@ -1102,7 +1251,7 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		.Padding(WordPadding)
 		[
 			SNew(STextBlock)
-			.Text(FText::Format(LOCTEXT("Meta_CreationLbl", "Created: {0}"), FText::FromString(AssetMeta->CreationDate.ToString())))
+			.Text(FText::Format(LOCTEXT("Meta_CreationLbl", "Created: {0}"), FText::FromString(AssetMeta.CreationDate.ToString())))
 		];
 
 	// Last Modified Date
@@ -1111,7 +1260,7 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		.Padding(WordPadding)
 		[
 			SNew(STextBlock)
-			.Text(FText::Format(LOCTEXT("Meta_LastModifiedLbl", "Last Modified: {0}"), FText::FromString(AssetMeta->LastModified.ToString())))
+			.Text(FText::Format(LOCTEXT("Meta_LastModifiedLbl", "Last Modified: {0}"), FText::FromString(AssetMeta.LastModified.ToString())))
 		];
 
 	// Category
@@ -1121,7 +1270,7 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		[
 			SNew(STextBlock)
 			.AutoWrapText(true)
-			.Text(FText::Format(LOCTEXT("MetaCategoryLbl", "Category: {0}"), FText::FromString(FVaultMetadata::CategoryToString(AssetMeta->Category))))
+			.Text(FText::Format(LOCTEXT("MetaCategoryLbl", "Category: {0}"), FText::FromString(FVaultMetadata::CategoryToString(AssetMeta.Category))))
 		];
 
 	// Tags List - Header
@@ -1131,12 +1280,12 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		[
 			SNew(STextBlock)
 			.AutoWrapText(true)
-			//.Text(FText::Format(LOCTEXT("Meta_TagsLbl", "Tags: {0}"), FText::FromString(FString::Join(AssetMeta->Tags.Array(), TEXT(",")))))
+			//.Text(FText::Format(LOCTEXT("Meta_TagsLbl", "Tags: {0}"), FText::FromString(FString::Join(AssetMeta.Tags.Array(), TEXT(",")))))
 			.Text(LOCTEXT("Meta_TagsLbl", "Tags:"))
 		];
 
 	// Tags, Per Tag. Instead of using Join, we add them as separate lines for ease of reading
-	for (auto MyTag : AssetMeta->Tags)
+	for (auto MyTag : AssetMeta.Tags)
 	{
 		MyTag.TrimStartAndEndInline();
 		const FText TagName = FText::FromString(MyTag);
@@ -1159,18 +1308,25 @@ void SLoaderWindow::ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta
 		[
 			SNew(STextBlock)
 			.AutoWrapText(true)
-			.Text(FText::Format(LOCTEXT("Meta_FilesLbl", "Files: {0}"), FText::FromString(FString::Join(AssetMeta->ObjectsInPack.Array(), TEXT(",")))))
+			.Text(FText::Format(LOCTEXT("Meta_FilesLbl", "Files: {0}"), FText::FromString(FString::Join(AssetMeta.ObjectsInPack.Array(), TEXT(",")))))
 		];
 
 }
 
-void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack)
+void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultLibraryItem> InItem)
 {
+	// Library records only carry the object list once it was asked for.
+	FVaultMetadata Pack = InItem->GetMetadata();
+	if (!FMetadataOps::LoadDetails(Pack))
+	{
+		return;
+	}
+
 	// Root Directory
 	const FString LibraryPath = FVaultSettings::Get().GetAssetLibraryRoot();
 
-	// All files live in same directory, so we just do some string mods to get the pack file that matches the meta file.
-	const FString AssetToImportTemp = LibraryPath / InPack->FileId.ToString() + ".upack";
+	// All files of a pack live in the same directory, the layout tells which one.
+	const FString AssetToImportTemp = FVaultLibraryLayout::GetPackFilePath(LibraryPath, Pack.FileId, TEXT("upack"));
 
 //#pragma region ImportTask
 //		// UPacks import natively with Unreal, so no need to try to use the PakUtilities, better to use the native importer and let Unreal handle the Pak concepts. 
@@ -1226,7 +1382,7 @@ void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack)
 
 	TArray<FString> TargetPathArray;
 
-	for (FString path : InPack->ObjectsInPack)
+	for (FString path : Pack.ObjectsInPack)
 	{
 		if (TargetPathArray.Num() <= 0)
 		{
@@ -1273,15 +1429,20 @@ void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack)
 
 	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
 	TArray<FAssetData> ImportedAssets;
-	for (FString ImportedPath : InPack->ObjectsInPack)
+	for (FString ImportedPath : Pack.ObjectsInPack)
 	{
 		FAssetData ImportedAsset = AssetRegistryModule.Get().GetAssetByObjectPath(FName(ImportedPath), true);
 		ImportedAsset.GetAsset();
 		ImportedAssets.Add(ImportedAsset);
 	}
 
-	FMetadataOps::CopyMetadataToLocal(*InPack);
-	InPack->InProjectVersion = 1;
+	FMetadataOps::CopyMetadataToLocal(Pack);
+	if (FVaultImportTracker* ImportTracker = FVaultModule::Get().GetImportTracker())
+	{
+		ImportTracker->TagImportedAssets(Pack, ImportedAssets);
+	}
+	// The tile picks up its new badge with the snapshot this publishes.
+	FVaultModule::Get().RefreshProjectVersions();
 
 	FContentBrowserModule& ContentBrowserModule = FModuleManager::Get().LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
 	TArray<FString> ImportedAssetFolders;
@@ -1289,7 +1450,7 @@ void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack)
 	FString FileName;
 	FString FileExtension;
 	FString ImportedFilePath = "";
-	for (auto& Element : InPack->ObjectsInPack)
+	for (auto& Element : Pack.ObjectsInPack)
 	{
 		ImportedFilePath = Element;
 		break;
@@ -1306,13 +1467,15 @@ void SLoaderWindow::LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack)
 
 }
 
-void SLoaderWindow::DeleteAssetPack(TSharedPtr<FVaultMetadata> InPack)
+void SLoaderWindow::DeleteAssetPack(TSharedPtr<FVaultLibraryItem> InItem)
 {
+	const FVaultMetadata& Pack = InItem->GetMetadata();
+
 	// Confirmation will have occurred already for this operation (Might be changed in future to have confirmation here)
-	UE_LOG(LogVault, Display, TEXT("Deleting File(s) from Vault: %s"), *InPack->PackName.ToString());
+	UE_LOG(LogVault, Display, TEXT("Deleting File(s) from Vault: %s"), *Pack.PackName.ToString());
 
 	const FString LibraryPath = FVaultSettings::Get().GetAssetLibraryRoot();
-	const FString FilePathAbsNoExt = LibraryPath / InPack->FileId.ToString();
+	const FString FilePathAbsNoExt = FVaultLibraryLayout::GetPackDirectory(LibraryPath, Pack.FileId) / Pack.FileId.ToString();
 	const FString AbsThumbnailPath = FilePathAbsNoExt + ".png";
 	const FString AbsMetaPath = FilePathAbsNoExt + ".meta";
 	const FString AbsPackPath = FilePathAbsNoExt + ".upack";
@@ -1321,9 +1484,11 @@ void SLoaderWindow::DeleteAssetPack(TSharedPtr<FVaultMetadata> InPack)
 	IFileManager::Get().Delete(*AbsMetaPath, true);
 	IFileManager::Get().Delete(*AbsPackPath, true);
 
+	FVaultLibraryIndex::RemoveEntry(Pack.FileId);
+	FVaultLibraryJournal::Append(LibraryPath, EVaultJournalOp::Delete, Pack.FileId);
 
-	FVaultModule::Get().MetaFilesCache.Remove(*InPack);
-	RefreshLibrary();
+	// Drop the pack from the library right away rather than waiting for the watcher to notice.
+	FVaultModule::Get().RequestPackRefresh(TSet<FName>({ Pack.FileId }));
 	//UpdateFilteredAssets();
 	//TileView->RebuildList();
 
@@ -1331,10 +1496,11 @@ void SLoaderWindow::DeleteAssetPack(TSharedPtr<FVaultMetadata> InPack)
 
 void SLoaderWindow::RefreshAvailableFiles()
 {
-	IsConnected = FVaultSettings::Get().CheckConnection();
-	if (IsConnected) {
-		FVaultModule::Get().UpdateMetaFilesCache();
-		FVaultStyle::CacheThumbnailsLocally();
+	// A refresh the user asked for is worth a probe even while backing off. If the share is back, the monitor refreshes the library itself.
+	FVaultConnectionMonitor::Get().RequestProbe(true);
+
+	if (FVaultConnectionMonitor::Get().IsReachable()) {
+		FVaultModule::Get().RequestLibraryRefresh();
 	}
 	else
 	{
@@ -1345,65 +1511,79 @@ void SLoaderWindow::RefreshAvailableFiles()
 // Applies the List of filters all together.
 void SLoaderWindow::UpdateFilteredAssets()
 {
-	FilteredAssetItems.Empty();
+	// The filters decide what the list shows now, not the search that was running.
+	CancelSearch();
+	CompletedSearchText.Reset();
+
+	FilteredRows.Reset();
 
-	// Special Condition to check if all boxes are cleared:
-	if (ActiveCategoryFilters.Num() == 0 && ActiveTagFilters.Num() == 0 && ActiveDevFilters.Num() == 0)
+	if (DisplayedLibrary.IsValid())
 	{
-		if (bHideBadHierarchyAssets == false)
+		const FVaultLibraryCatalog& Catalog = *DisplayedLibrary->Catalog;
+		const int32 NumRows = Catalog.Num();
+
+		// Within a filter group any match is enough, across groups all have to match. Empty groups don't filter.
+		FVaultRowSet Rows;
+		Rows.Init(NumRows, true);
+
+		// Skip assets with bad hierarchy if we are hiding those
+		if (bHideBadHierarchyAssets)
 		{
-			PopulateBaseAssetList();
-			TileView->RebuildList();
-			TileView->ScrollToTop();
-			return;
+			Rows.Subtract(Catalog.RowsWithBadHierarchy);
 		}
-		else 
+
+		if (ActiveCategoryFilters.Num() > 0)
 		{
-			for (auto Asset : FVaultModule::Get().MetaFilesCache)
+			FVaultRowSet CategoryRows;
+			CategoryRows.Init(NumRows, false);
+			for (const FVaultCategory Category : ActiveCategoryFilters)
 			{
-				if (Asset.HierarchyBadness <= 0)
+				if (Catalog.RowsByCategory.IsValidIndex(Category))
 				{
-					FilteredAssetItems.Add(MakeShareable(new FVaultMetadata(Asset)));
+					CategoryRows.Union(Catalog.RowsByCategory[Category]);
 				}
 			}
-			TileView->RebuildList();
-			TileView->ScrollToTop();
-			return;
-		}
-	}
-
-	for (auto Asset : FVaultModule::Get().MetaFilesCache)
-	{
-		// Skip this asset if it has bad hierarchy and we are hiding those
-		if (bHideBadHierarchyAssets && Asset.HierarchyBadness > 0)
-		{
-			continue;
+			Rows.Intersect(CategoryRows);
 		}
 
-		// Apply all filtered Categories
-		if (ActiveTagFilters.Num() == 0 && ActiveDevFilters.Num() == 0 && ActiveCategoryFilters.Contains(Asset.Category))
+		// Developers are picked by name, the catalog stores author ids.
+		if (ActiveDevFilters.Num() > 0)
 		{
-			FilteredAssetItems.Add(MakeShareable(new FVaultMetadata(Asset)));
-			continue;
+			FVaultRowSet AuthorRows;
+			AuthorRows.Init(NumRows, false);
+			for (const FName& Developer : ActiveDevFilters)
+			{
+				if (const FVaultRowGroup* DeveloperRows = Catalog.RowsByAuthorId.Find(FVaultStringDictionary::Authors().Find(Developer.ToString())))
+				{
+					DeveloperRows->AddTo(AuthorRows);
+				}
+			}
+			Rows.Intersect(AuthorRows);
 		}
 
-		// Apply all filtered Tags
-		for (auto UserTag : Asset.Tags)
+		if (ActiveTagFilters.Num() > 0)
 		{
-			if (ActiveTagFilters.Contains(UserTag) && (ActiveDevFilters.Contains(Asset.Author) || ActiveDevFilters.Num() == 0) && (ActiveCategoryFilters.Contains(Asset.Category) || ActiveCategoryFilters.Num() == 0))
+			FVaultRowSet TagRows;
+			TagRows.Init(NumRows, false);
+			for (const int32 TagId : ActiveTagFilters)
 			{
-				FilteredAssetItems.Add(MakeShareable(new FVaultMetadata(Asset)));
-				break;
+				if (const FVaultRowGroup* RowsWithTag = Catalog.RowsByTagId.Find(TagId))
+				{
+					RowsWithTag->AddTo(TagRows);
+				}
 			}
+			Rows.Intersect(TagRows);
 		}
 
-		// Apply All Developer Tags
-		if (ActiveTagFilters.Num() == 0 && ActiveDevFilters.Contains(Asset.Author) && (ActiveCategoryFilters.Contains(Asset.Category) || ActiveCategoryFilters.Num() == 0))
-		{
-			FilteredAssetItems.Add(MakeShareable(new FVaultMetadata(Asset)));
-			continue;
-		}
+		Rows.GetRows(FilteredRows);
+		FilterRows = MoveTemp(Rows);
 	}
+	else
+	{
+		FilterRows.Init(0, false);
+	}
+
+	UpdateFilteredAssetItems();
 
 	TileView->RebuildList();
 	TileView->ScrollToTop();
@@ -1414,26 +1594,15 @@ void SLoaderWindow::SortFilteredAssets(TEnumAsByte<SortingTypes> SortingType, bo
 {
 	bSortingReversed = Reverse;
 	ActiveSortingType = SortingType;
-	switch (SortingType) {
-	case SortingTypes::Filename : 
-		FilteredAssetItems.Sort([&](const TSharedPtr<FVaultMetadata>& a, const TSharedPtr<FVaultMetadata>& b) 
-		{
-			return Reverse ? b->PackName.LexicalLess(a->PackName) : a->PackName.LexicalLess(b->PackName);
-		});
-		break;
-	case SortingTypes::CreationDate:
-		FilteredAssetItems.Sort([&](const TSharedPtr<FVaultMetadata>& a, const TSharedPtr<FVaultMetadata>& b) 
-			{
-			return Reverse ? a->CreationDate < b->CreationDate : a->CreationDate > b->CreationDate;
-		});
-		break;
-	case SortingTypes::ModificationDate:
-		FilteredAssetItems.Sort([&](const TSharedPtr<FVaultMetadata>& a, const TSharedPtr<FVaultMetadata>& b) 
-			{
-			return Reverse ? a->LastModified < b->LastModified : a->LastModified > b->LastModified;
-		});
-		break;
+
+	if (!DisplayedLibrary.IsValid())
+	{
+		return;
 	}
+
+	DisplayedLibrary->Catalog->SortRows(FilteredRows, SortingType, Reverse);
+
+	UpdateFilteredAssetItems();
 }
 
 void SLoaderWindow::SortFilteredAssets()
@@ -1451,7 +1620,7 @@ void SLoaderWindow::OnThumbnailSliderValueChanged(float Value)
 
 FText SLoaderWindow::DisplayTotalAssetsInLibrary() const
 {
-	int assetCount = FVaultModule::Get().MetaFilesCache.Num();
+	int assetCount = DisplayedLibrary.IsValid() ? DisplayedLibrary->Assets.Num() : 0;
 
 	FText Display = FText::Format(LOCTEXT("displayassetcountlabel", "Total Assets in library: {0}"),assetCount);
 	return Display;
@@ -1465,7 +1634,13 @@ FReply SLoaderWindow::OnRefreshLibraryClicked()
 
 void SLoaderWindow::RefreshLibrary()
 {
+	// Views are rebuilt once the new library snapshot is published.
 	RefreshAvailableFiles();
+}
+
+void SLoaderWindow::RefreshLibraryViews()
+{
+	CacheLibraryItems();
 	PopulateCategoryArray();
 	PopulateTagArray();
 	PopulateDeveloperNameArray();
@@ -1501,9 +1676,9 @@ void SLoaderWindow::ModifyActiveCategoryFilters(FVaultCategory CategoryModified,
 	SortFilteredAssets();
 }
 
-void SLoaderWindow::ModifyActiveTagFilters(FString TagModified, bool bFilterThis)
+void SLoaderWindow::ModifyActiveTagFilters(int32 TagModified, bool bFilterThis)
 {
-	UE_LOG(LogVault, Display, TEXT("Enabling Tag Filter For %s"), *TagModified);
+	UE_LOG(LogVault, Display, TEXT("Enabling Tag Filter For %s"), *FVaultStringDictionary::Tags().GetString(TagModified));
 	
 	if (bFilterThis)
 	{
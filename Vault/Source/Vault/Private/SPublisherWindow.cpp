@@ -5,8 +5,11 @@
 #include "AssetPublisherTagsCustomization.h"
 #include "Vault.h"
 #include "VaultSettings.h"
+#include "VaultLibraryLayout.h"
 #include "VaultStyle.h"
 #include "MetadataOps.h"
+#include "VaultLibraryIndex.h"
+#include "VaultLibraryJournal.h"
 
 #include "Misc/DateTime.h"
 #include "Engine/Engine.h"
@@ -906,13 +909,10 @@ FReply SPublisherWindow::TryPackage()
 
 #pragma endregion
 
-	FName FileId = UAssetPublisher::CreateUniquePackageFilename();
-
 	FVaultMetadata AssetPublishMetadata;
 
 	AssetPublishMetadata.Author = FName(*AuthorInput->GetText().ToString());
 	AssetPublishMetadata.PackName = FName(*PackageNameInput->GetText().ToString());
-	AssetPublishMetadata.FileId = FileId;
 	AssetPublishMetadata.Description = DescriptionInput->GetText().ToString();
 	AssetPublishMetadata.CreationDate = FDateTime::UtcNow();
 	AssetPublishMetadata.LastModified = FDateTime::UtcNow();
@@ -930,7 +930,8 @@ FReply SPublisherWindow::TryPackage()
 
 	UE_LOG(LogVault, Display, TEXT("Starting Packaging Operation"));
 
-	return UAssetPublisher::TryPackageAsset(FileId.ToString(), CurrentlySelectedAsset, AssetPublishMetadata, ShotTexture);
+	// The FileId is picked by the publisher, once it knows whether this replaces an existing pack.
+	return UAssetPublisher::TryPackageAsset(FString(), CurrentlySelectedAsset, AssetPublishMetadata, ShotTexture);
 }
 
 FReply SPublisherWindow::TryUpdateMetadata()
@@ -948,7 +949,7 @@ FReply SPublisherWindow::TryUpdateMetadata()
 	}
 
 	const FString LibraryPath = FVaultSettings::Get().GetAssetLibraryRoot();
-	const FString MetaFilePath = LibraryPath / PackageNameInput->GetText().ToString() + ".meta";
+	const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(LibraryPath, FName(*PackageNameInput->GetText().ToString()), TEXT("meta"));
 
 	FVaultMetadata AssetPublishMetadata = FMetadataOps::ReadMetadata(MetaFilePath);
 
@@ -967,6 +968,8 @@ FReply SPublisherWindow::TryUpdateMetadata()
 	UE_LOG(LogVault, Display, TEXT("Updating Metadata"));
 
 	FMetadataOps::WriteMetadata(AssetPublishMetadata);
+	FVaultLibraryIndex::AddOrUpdateEntry(AssetPublishMetadata);
+	FVaultLibraryJournal::Append(FVaultSettings::Get().GetAssetLibraryRoot(), EVaultJournalOp::Update, AssetPublishMetadata.FileId);
 
 	return FReply::Handled();
 }
@@ -1285,7 +1288,7 @@ bool SPublisherWindow::OpenWithMetadata(FVaultMetadata AssetMetadata)
 		UE_LOG(LogVault, Warning, TEXT("Original root asset (%s) of the selected package doesn't exist in this project!"), *ObjectPath);
 	}
 
-	FString SourceImagePath = FVaultSettings::Get().GetAssetLibraryRoot() + FGenericPlatformMisc::GetDefaultPathSeparator() + AssetMetadata.FileId.ToString() + ".png";
+	FString SourceImagePath = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), AssetMetadata.FileId, TEXT("png"));
 
 	ShotTexture = CreateThumbnailFromFile(SourceImagePath);
 	FSlateBrush Brush;
@@ -8,6 +8,7 @@
 #include "SVaultRootPanel.h"
 #include "MainFrame/Public/Interfaces/IMainFrameModule.h"
 #include "VaultSettings.h"
+#include "VaultConnectionMonitor.h"
 #include "SPublisherWindow.h"
 #include "AssetPublisher.h"
 #include "LevelEditor.h"
@@ -16,9 +17,15 @@
 
 #include "HAL/PlatformProcess.h"
 #include "Misc/Paths.h"
+#include "HAL/FileManager.h"
 #include "Interfaces/IPluginManager.h"
 #include "ContentBrowserModule.h"
 #include "Metadataops.h"
+#include "VaultLibraryIndex.h"
+#include "VaultLibraryJournal.h"
+#include "VaultLibraryCache.h"
+#include "Async/Async.h"
+#include "Misc/CoreDelegates.h"
 
 static const FName VaultTabName("VaultOperations");
 static const FName VaultPublisherName("VaultPublisher");
@@ -32,21 +39,14 @@ DEFINE_LOG_CATEGORY(LogVault);
 
 void FVaultModule::StartupModule()
 {
+	const double StartTime = FPlatformTime::Seconds();
 
 	// Init our styles
 	FVaultStyle::Initialize();
 
-	FVaultStyle::CacheThumbnailsLocally();
-
-	// Reload Textures
-	FVaultStyle::ReloadTextures();
-
 	// Register our Vault Commands into the Engine
 	FVaultCommands::Register();
 
-	// Init the Settings system
-	FVaultSettings::Get().Initialize();
-
 	PluginCommands = MakeShareable(new FUICommandList);
 
 	PluginCommands->MapAction(
@@ -92,10 +92,83 @@ void FVaultModule::StartupModule()
 		.SetTooltipText(VaultBasePanelWindowTooltip)
 		.SetIcon(FSlateIcon("VaultStyle", "Vault.Icon16px"))
 		.SetMenuType(ETabSpawnerMenuType::Hidden); //Hide root menu from the windows dropdown
+
+	// Everything that touches disk or the network waits until the editor is up, see StartDeferredStartup.
+	if (GIsRunning)
+	{
+		StartDeferredStartup();
+	}
+	else
+	{
+		EngineLoopInitCompleteHandle = FCoreDelegates::OnFEngineLoopInitComplete.AddRaw(this, &FVaultModule::StartDeferredStartup);
+	}
+
+	UE_LOG(LogVault, Display, TEXT("Vault module startup took %.2f ms."), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FVaultModule::StartDeferredStartup()
+{
+	FCoreDelegates::OnFEngineLoopInitComplete.Remove(EngineLoopInitCompleteHandle);
+	EngineLoopInitCompleteHandle.Reset();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The settings files may live on the share, read them on the thread pool.
+	Async(EAsyncExecution::ThreadPool, [StartTime]()
+	{
+		const bool bFilesExisted = FVaultSettings::Get().PrepareFiles();
+
+		// Settings folders on the share are looked at here, the game thread only registers watches on those that answered.
+		TArray<FString> WatchDirectories = FVaultSettings::Get().FindWatchableDirectories();
+		const double SettingsSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AsyncTask(ENamedThreads::GameThread, [StartTime, SettingsSeconds, bFilesExisted, WatchDirectories = MoveTemp(WatchDirectories)]()
+		{
+			// The editor may have shut the module down while we were reading.
+			FVaultModule* VaultModule = FModuleManager::GetModulePtr<FVaultModule>(TEXT("Vault"));
+			if (!VaultModule)
+			{
+				return;
+			}
+
+			VaultModule->FinishDeferredStartup(bFilesExisted, WatchDirectories);
+
+			UE_LOG(LogVault, Display, TEXT("Vault deferred startup finished after %.2f ms, %.2f ms of it reading settings in the background."),
+				(FPlatformTime::Seconds() - StartTime) * 1000.0, SettingsSeconds * 1000.0);
+		});
+	});
+}
+
+void FVaultModule::FinishDeferredStartup(bool bSettingsFilesExisted, const TArray<FString>& SettingsWatchDirectories)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FVaultSettings::Get().Initialize(bSettingsFilesExisted, SettingsWatchDirectories);
+
+	// Probes the library in the background, nothing waits on the share from here on.
+	FVaultConnectionMonitor::Get().Start();
+
+	ImportTracker = MakeUnique<FVaultImportTracker>();
+	ImportTracker->Start();
+
+	// Reload Textures
+	FVaultStyle::ReloadTextures();
+
+	// Scan the library ahead of the loader being opened. Thumbnails are cached once the snapshot is published.
+	RequestLibraryRefresh();
+
+	UE_LOG(LogVault, Display, TEXT("Vault deferred startup spent %.2f ms on the game thread."), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
 void FVaultModule::ShutdownModule()
 {
+	FCoreDelegates::OnFEngineLoopInitComplete.Remove(EngineLoopInitCompleteHandle);
+
+	LibraryWatcher.Reset();
+	ImportTracker.Reset();
+	FVaultConnectionMonitor::Get().Stop();
+	FVaultSettings::Get().Shutdown();
+
 	FVaultStyle::Shutdown();
 	FVaultCommands::Unregister();
 	TSharedRef<FGlobalTabmanager> TabManager = FGlobalTabmanager::Get();
@@ -177,41 +250,401 @@ bool FVaultModule::LoadDependency(const FString& Dir, const FString& Name, void*
 
 void FVaultModule::UpdateMetaFilesCache()
 {
-	MetaFilesCache = FMetadataOps::FindAllMetadataInLibrary();
-	ImportedMetaFileCache = FMetadataOps::FindAllMetadataImportedInProject();
+	FLibraryRefreshRequest Request;
+	Request.bFullRescan = true;
+	Request.bRecheckProjectVersions = true;
+
+	const FString LibraryRoot = FVaultSettings::Get().GetAssetLibraryRoot();
+	WatchLibrary(LibraryRoot);
+
+	const uint32 Serial = ++LibraryRefreshSerial;
+	FLibraryRefreshResult Result = RunLibraryRefresh(LibrarySnapshot, LibraryRoot, Request, LibraryJournalGeneration, LibraryShardTimes);
+	FinishLibraryRefresh(Result, Request, Serial);
+}
+
+void FVaultModule::RequestLibraryRefresh(bool bRecheckProjectVersions, bool bReplayJournal)
+{
+	FLibraryRefreshRequest Request;
+	Request.bFullRescan = true;
+	Request.bRecheckProjectVersions = bRecheckProjectVersions;
+	Request.bReplayJournal = bReplayJournal;
+	QueueLibraryRefresh(Request);
+}
+
+void FVaultModule::RequestPackRefresh(const TSet<FName>& FileIds, const TSet<FName>& ThumbnailFileIds)
+{
+	FLibraryRefreshRequest Request;
+	Request.FileIds = FileIds;
+	Request.ThumbnailFileIds = ThumbnailFileIds;
+	QueueLibraryRefresh(Request);
+}
+
+void FVaultModule::FLibraryRefreshRequest::Merge(const FLibraryRefreshRequest& Other)
+{
+	// A full rescan only trusts the journal if every full rescan folded into it was happy to.
+	if (Other.bFullRescan)
+	{
+		bReplayJournal = (bFullRescan ? bReplayJournal : true) && Other.bReplayJournal;
+	}
+
+	bFullRescan |= Other.bFullRescan;
+	bRecheckProjectVersions |= Other.bRecheckProjectVersions;
+	ThumbnailFileIds.Append(Other.ThumbnailFileIds);
+	FileIds.Append(Other.FileIds);
+}
+
+void FVaultModule::QueueLibraryRefresh(const FLibraryRefreshRequest& Request)
+{
+	check(IsInGameThread());
+
+	QueuedRefresh.Merge(Request);
+	bLibraryRefreshQueued = true;
+
+	// Requests arriving while a scan runs are folded into one follow-up scan.
+	if (!bLibraryRefreshInFlight)
+	{
+		StartQueuedLibraryRefresh();
+	}
+}
+
+void FVaultModule::StartQueuedLibraryRefresh()
+{
+	if (!bLibraryRefreshQueued)
+	{
+		return;
+	}
+
+	const FLibraryRefreshRequest Request = MoveTemp(QueuedRefresh);
+	QueuedRefresh = FLibraryRefreshRequest();
+	bLibraryRefreshQueued = false;
+
+	const FString LibraryRoot = FVaultSettings::Get().GetAssetLibraryRoot();
+	WatchLibrary(LibraryRoot);
+
+	bLibraryRefreshInFlight = true;
+
+	const uint32 Serial = ++LibraryRefreshSerial;
+	const FVaultLibrarySnapshotPtr Previous = LibrarySnapshot;
+	const TOptional<uint64> JournalGeneration = LibraryJournalGeneration;
+	const TMap<FString, FDateTime> ShardTimes = LibraryShardTimes;
+
+	// First scan of the session. Show what we saw last time while the share is checked.
+	const bool bWarmStart = !Previous.IsValid() && Request.bFullRescan;
+
+	Async(EAsyncExecution::ThreadPool, [Previous, LibraryRoot, Request, JournalGeneration, ShardTimes, bWarmStart, Serial]()
+	{
+		FVaultLibrarySnapshotPtr Base = Previous;
+
+		if (bWarmStart)
+		{
+			TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Cached = FVaultLibraryCache::Load(LibraryRoot);
+			if (Cached.IsValid())
+			{
+				// The scan keeps reading the cached snapshot, the game thread gets its own copy to finish and publish.
+				// Both share the indices, built here rather than on the game thread.
+				Cached->BuildIndices();
+				TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> WarmSnapshot = MakeShared<FVaultLibrarySnapshot, ESPMode::ThreadSafe>(*Cached);
+				Base = Cached;
+
+				AsyncTask(ENamedThreads::GameThread, [WarmSnapshot]()
+				{
+					if (FVaultModule* VaultModule = FModuleManager::GetModulePtr<FVaultModule>(TEXT("Vault")))
+					{
+						VaultModule->PublishCachedSnapshot(WarmSnapshot);
+					}
+				});
+			}
+		}
+
+		FLibraryRefreshResult Result = RunLibraryRefresh(Base, LibraryRoot, Request, JournalGeneration, ShardTimes);
+
+		AsyncTask(ENamedThreads::GameThread, [Result = MoveTemp(Result), Request, Serial]() mutable
+		{
+			// The editor may have shut the module down while we were scanning.
+			FVaultModule* VaultModule = FModuleManager::GetModulePtr<FVaultModule>(TEXT("Vault"));
+			if (!VaultModule)
+			{
+				return;
+			}
+
+			VaultModule->bLibraryRefreshInFlight = false;
+			VaultModule->FinishLibraryRefresh(Result, Request, Serial);
+			VaultModule->StartQueuedLibraryRefresh();
+		});
+	});
+}
+
+FVaultModule::FLibraryRefreshResult FVaultModule::RunLibraryRefresh(const FVaultLibrarySnapshotPtr& Previous, const FString& LibraryRoot, const FLibraryRefreshRequest& Request, const TOptional<uint64>& JournalGeneration,
+	const TMap<FString, FDateTime>& KnownShardTimes)
+{
+	FLibraryRefreshResult Result;
+
+	// An unreachable share looks exactly like an empty library, never publish that.
+	Result.bLibraryReachable = !LibraryRoot.IsEmpty() && IFileManager::Get().DirectoryExists(*LibraryRoot);
+	if (!Result.bLibraryReachable)
+	{
+		return Result;
+	}
 
-	for (int i = 0; i < MetaFilesCache.Num(); i++)
+	// Copied before the snapshot is published, so tiles rebuilt for it load the new pictures.
+	for (const FName& FileId : Request.ThumbnailFileIds)
 	{
-		MetaFilesCache[i].CheckVersion();
+		FVaultStyle::CacheThumbnailLocally(FileId);
 	}
 
-	for (int i = 0; i < ImportedMetaFileCache.Num(); i++)
+	const TSet<FName>* OnlyFileIds = Request.bFullRescan ? nullptr : &Request.FileIds;
+	TSet<FName> JournalFileIds;
+
+	if (Request.bFullRescan)
 	{
-		bool AssetDeleted = true;
-		for (int j = 0; j < MetaFilesCache.Num(); j++)
+		bool bReplayed = false;
+
+		// Catch up on what others published, updated, renamed or deleted since our last refresh, rather than statting the whole library.
+		if (Request.bReplayJournal && JournalGeneration.IsSet() && Previous.IsValid() && Previous->LibraryRoot == LibraryRoot)
 		{
-			if (MetaFilesCache[j].FileId == ImportedMetaFileCache[i].FileId)
+			uint64 EndGeneration = 0;
+			const FVaultLibraryJournal::EReadResult ReadResult = FVaultLibraryJournal::ReadSince(LibraryRoot, JournalGeneration.GetValue(), JournalFileIds, EndGeneration);
+
+			if (ReadResult == FVaultLibraryJournal::EReadResult::Ok)
+			{
+				UE_LOG(LogVault, Display, TEXT("Replaying library journal: %d packs changed."), JournalFileIds.Num());
+				JournalFileIds.Append(Request.FileIds);
+				OnlyFileIds = &JournalFileIds;
+				Result.JournalGeneration = EndGeneration;
+				bReplayed = true;
+			}
+			else if (ReadResult == FVaultLibraryJournal::EReadResult::Compacted)
 			{
-				AssetDeleted = false;
+				UE_LOG(LogVault, Display, TEXT("Library journal was compacted since the last refresh, rescanning."));
 			}
 		}
-		if (AssetDeleted)
+
+		// Take the journal position before the scan. Whatever gets written during the scan is replayed again next time, which is harmless.
+		if (!bReplayed && IFileManager::Get().FileExists(*FVaultLibraryJournal::GetJournalFilePath(LibraryRoot)))
 		{
-			FMetadataOps::DeleteMetadata(ImportedMetaFileCache[i]);
+			Result.JournalGeneration = FVaultLibraryJournal::GetEndGeneration(LibraryRoot);
 		}
 	}
 
+	// A poll the journal couldn't answer only lists the shards that changed. Everything else lists the whole library,
+	// that catches .meta files rewritten in place, which leave their directory's time alone.
+	TMap<FString, FDateTime> ShardTimes;
+	const bool bListsLibrary = OnlyFileIds == nullptr;
+	const TMap<FString, FDateTime>* SkippableShardTimes = Request.bReplayJournal ? &KnownShardTimes : nullptr;
 
-	/*for (int i = 0; i < ImportedMetaFileCache.Num(); i++)
+	Result.Snapshot = FVaultLibrarySnapshot::Build(Previous, LibraryRoot, OnlyFileIds, SkippableShardTimes, bListsLibrary ? &ShardTimes : nullptr);
+	if (bListsLibrary)
 	{
-		ImportedMetaFileCache[i].CheckVersion();
-		if (ImportedMetaFileCache[i].InProjectVersion == -2)
+		Result.ShardTimes = MoveTemp(ShardTimes);
+	}
+
+	if (Result.Snapshot.IsValid())
+	{
+		Result.Snapshot->BuildIndices(Previous.Get());
+	}
+
+	if (Request.bFullRescan)
+	{
+		Result.ImportedMetadata = FMetadataOps::FindAllMetadataImportedInProject();
+
+		// Check the imported packs against the project's content folder while we are off the game thread, so CheckVersion never touches the disk.
+		Result.ImportedPackPresence.Reserve(Result.ImportedMetadata.Num());
+		for (const FVaultMetadata& Imported : Result.ImportedMetadata)
+		{
+			bool bPresent = false;
+			if (Imported.ObjectsInPack.Num() > 0)
+			{
+				FString ObjectPath = *Imported.ObjectsInPack.CreateConstIterator();
+				ObjectPath.RemoveFromStart(TEXT("/Game/"));
+				bPresent = FPaths::FileExists(FPaths::ProjectContentDir() + ObjectPath + TEXT(".uasset"));
+			}
+			Result.ImportedPackPresence.Add(Imported.FileId, bPresent);
+		}
+	}
+
+	return Result;
+}
+
+void FVaultModule::FinishLibraryRefresh(FLibraryRefreshResult& Result, const FLibraryRefreshRequest& Request, uint32 Serial)
+{
+	check(IsInGameThread());
+
+	// A refresh that started later already finished. It scanned everything this one did, and saw a newer library.
+	if (Serial < FinishedLibraryRefreshSerial)
+	{
+		UE_LOG(LogVault, Verbose, TEXT("Dropping the result of an overtaken library refresh."));
+
+		// Its thumbnails were copied all the same, views still need to redraw for them.
+		if (Request.ThumbnailFileIds.Num() > 0)
+		{
+			OnLibrarySnapshotPublished.Broadcast();
+		}
+		return;
+	}
+	FinishedLibraryRefreshSerial = Serial;
+
+	if (!Result.bLibraryReachable)
+	{
+		UE_LOG(LogVault, Warning, TEXT("Couldn't reach the asset library, keeping the last known state."));
+		return;
+	}
+
+	if (Result.ShardTimes.IsSet())
+	{
+		LibraryShardTimes = MoveTemp(Result.ShardTimes.GetValue());
+	}
+
+	if (Request.bFullRescan)
+	{
+		ImportedMetaFileCache = MoveTemp(Result.ImportedMetadata);
+		ImportedPackPresence = MoveTemp(Result.ImportedPackPresence);
+		LibraryJournalGeneration = Result.JournalGeneration;
+
+		ImportedMetaFileIndex.Reset();
+		ImportedMetaFileIndex.Reserve(ImportedMetaFileCache.Num());
+		for (int32 ImportedIndex = 0; ImportedIndex < ImportedMetaFileCache.Num(); ImportedIndex++)
+		{
+			ImportedMetaFileIndex.Add(ImportedMetaFileCache[ImportedIndex].FileId, ImportedIndex);
+		}
+	}
+
+	TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> NewSnapshot = Result.Snapshot;
+	bool bPublish = NewSnapshot.IsValid();
+
+	// The library did not change, but what is imported into this project might have.
+	// The copy shares the catalog and search index, only the records are duplicated.
+	if (!NewSnapshot.IsValid() && Request.bRecheckProjectVersions && LibrarySnapshot.IsValid())
+	{
+		NewSnapshot = MakeShared<FVaultLibrarySnapshot, ESPMode::ThreadSafe>(*LibrarySnapshot);
+	}
+
+	if (NewSnapshot.IsValid())
+	{
+		for (FVaultMetadata& Meta : NewSnapshot->Assets)
 		{
-			FMetadataOps::DeleteMetadata(ImportedMetaFileCache[i]);
+			const int32 PreviousVersion = Meta.InProjectVersion;
+			if (Meta.CheckVersion() != PreviousVersion)
+			{
+				bPublish = true;
+			}
 		}
-	}*/
+	}
+
+	if (Request.bFullRescan)
+	{
+		const FVaultLibrarySnapshot* Library = bPublish ? NewSnapshot.Get() : LibrarySnapshot.Get();
+
+		// Imported packs that are gone from the library lose their local .meta copy. One pass over the library marks the ones still there.
+		if (Library)
+		{
+			TBitArray<> StillInLibrary(false, ImportedMetaFileCache.Num());
+			for (const FVaultMetadata& Meta : Library->Assets)
+			{
+				if (const int32* ImportedIndex = ImportedMetaFileIndex.Find(Meta.FileId))
+				{
+					StillInLibrary[*ImportedIndex] = true;
+				}
+			}
 
+			for (int32 ImportedIndex = 0; ImportedIndex < ImportedMetaFileCache.Num(); ImportedIndex++)
+			{
+				if (!StillInLibrary[ImportedIndex])
+				{
+					FMetadataOps::DeleteMetadata(ImportedMetaFileCache[ImportedIndex]);
+				}
+			}
+		}
+	}
+
+	if (bPublish)
+	{
+		// A targeted refresh that landed on a different library root has no journal position for it yet.
+		if (!Request.bFullRescan && LibrarySnapshot.IsValid() && LibrarySnapshot->LibraryRoot != NewSnapshot->LibraryRoot)
+		{
+			LibraryJournalGeneration.Reset();
+		}
+
+		NewSnapshot->Generation = ++LibrarySnapshotGeneration;
+		LibrarySnapshot = NewSnapshot;
+
+		OnLibrarySnapshotPublished.Broadcast();
+
+		if (Request.bFullRescan)
+		{
+			FVaultStyle::CacheThumbnailsLocally();
+		}
+
+		FVaultLibraryCache::SaveAsync(LibrarySnapshot);
+	}
+	else if (Request.ThumbnailFileIds.Num() > 0)
+	{
+		// Same packs, new pictures. Views only need to redraw.
+		OnLibrarySnapshotPublished.Broadcast();
+	}
+}
+
+void FVaultModule::PublishCachedSnapshot(const TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe>& CachedSnapshot)
+{
+	check(IsInGameThread());
+
+	// Something faster than the cache got there first.
+	if (LibrarySnapshot.IsValid())
+	{
+		return;
+	}
+
+	for (FVaultMetadata& Meta : CachedSnapshot->Assets)
+	{
+		Meta.CheckVersion();
+	}
+
+	CachedSnapshot->Generation = ++LibrarySnapshotGeneration;
+	LibrarySnapshot = CachedSnapshot;
+
+	UE_LOG(LogVault, Display, TEXT("Showing %d cached packs while the library is checked."), CachedSnapshot->Assets.Num());
+
+	OnLibrarySnapshotPublished.Broadcast();
+}
+
+void FVaultModule::RefreshProjectVersions()
+{
+	// Only what is imported changed, the library snapshot itself is still current.
+	FLibraryRefreshRequest Request;
+	Request.bRecheckProjectVersions = true;
+
+	FLibraryRefreshResult Result;
+	Result.bLibraryReachable = true;
+
+	// No scan of its own, so it never overtakes one that is running.
+	FinishLibraryRefresh(Result, Request, FinishedLibraryRefreshSerial);
+}
+
+const FVaultMetadata* FVaultModule::FindImportedMetadata(FName FileId) const
+{
+	const int32* ImportedIndex = ImportedMetaFileIndex.Find(FileId);
+	return ImportedIndex ? &ImportedMetaFileCache[*ImportedIndex] : nullptr;
+}
+
+bool FVaultModule::IsImportedPackPresent(FName FileId) const
+{
+	const bool* bPresent = ImportedPackPresence.Find(FileId);
+	return !bPresent || *bPresent;
+}
+
+void FVaultModule::WatchLibrary(const FString& LibraryRoot)
+{
+	if (LibraryWatcher.IsValid() && LibraryRoot == WatchedLibraryRoot)
+	{
+		return;
+	}
+
+	if (!LibraryWatcher.IsValid())
+	{
+		LibraryWatcher = MakeUnique<FVaultLibraryWatcher>();
+	}
 
+	LibraryWatcher->Start(LibraryRoot);
+	WatchedLibraryRoot = LibraryRoot;
 }
 
 void FVaultModule::HandleRenameAsset()
@@ -0,0 +1,158 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultConnectionMonitor.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+
+const double FVaultConnectionMonitor::ProbeInterval = 15.0;
+const double FVaultConnectionMonitor::MaxProbeBackoff = 240.0;
+
+// How often the ticker checks for due probes and timeouts.
+static const float MonitorTickInterval = 0.25f;
+
+FVaultConnectionMonitor& FVaultConnectionMonitor::Get()
+{
+	static FVaultConnectionMonitor ConnectionMonitor;
+	return ConnectionMonitor;
+}
+
+void FVaultConnectionMonitor::Start()
+{
+	if (TickerHandle.IsValid())
+	{
+		return;
+	}
+
+	NextProbeTime = 0.0;
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FVaultConnectionMonitor::Tick), MonitorTickInterval);
+
+	StartProbe();
+}
+
+void FVaultConnectionMonitor::Stop()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	// A probe still out reports back to nobody.
+	CurrentProbeId++;
+	bProbeInFlight = false;
+}
+
+void FVaultConnectionMonitor::RequestProbe(bool bIgnoreBackoff)
+{
+	check(IsInGameThread());
+
+	if (State == EVaultConnectionState::Offline && !bIgnoreBackoff)
+	{
+		return;
+	}
+
+	NextProbeTime = 0.0;
+	StartProbe();
+}
+
+bool FVaultConnectionMonitor::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (bProbeInFlight)
+	{
+		// The share is hanging. Say so now, the probe can take as long as the OS wants to return.
+		if (!bProbeTimedOut && Now - ProbeStartTime >= ProbeTimeout)
+		{
+			bProbeTimedOut = true;
+			UE_LOG(LogVault, Warning, TEXT("Asset library didn't answer within %.1fs, treating it as offline."), ProbeTimeout);
+			SetState(EVaultConnectionState::Offline);
+		}
+	}
+	else if (Now >= NextProbeTime)
+	{
+		StartProbe();
+	}
+
+	return true;
+}
+
+void FVaultConnectionMonitor::StartProbe()
+{
+	// At most one probe at a time, hung ones would otherwise pile up on the thread pool.
+	if (bProbeInFlight)
+	{
+		return;
+	}
+
+	bProbeInFlight = true;
+	bProbeTimedOut = false;
+	ProbeStartTime = FPlatformTime::Seconds();
+
+	// Read once here, Tick never goes near the settings while a probe may be hanging on the share.
+	ProbeTimeout = FVaultSettings::Get().GetConnectionProbeTimeout();
+	const uint32 ProbeId = ++CurrentProbeId;
+
+	Async(EAsyncExecution::ThreadPool, [ProbeId]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		const bool bReachable = FVaultSettings::Get().CheckConnection();
+		const double Duration = FPlatformTime::Seconds() - StartTime;
+
+		AsyncTask(ENamedThreads::GameThread, [ProbeId, bReachable, Duration]()
+		{
+			FVaultConnectionMonitor::Get().FinishProbe(ProbeId, bReachable, Duration);
+		});
+	});
+}
+
+void FVaultConnectionMonitor::FinishProbe(uint32 ProbeId, bool bReachable, double Duration)
+{
+	if (ProbeId != CurrentProbeId)
+	{
+		return;
+	}
+
+	bProbeInFlight = false;
+
+	if (bReachable)
+	{
+		ConsecutiveFailures = 0;
+		NextProbeTime = FPlatformTime::Seconds() + ProbeInterval;
+		SetState(Duration > ProbeTimeout * 0.5 ? EVaultConnectionState::Degraded : EVaultConnectionState::Connected);
+	}
+	else
+	{
+		ConsecutiveFailures++;
+		const double Backoff = FMath::Min(ProbeInterval * FMath::Pow(2.0, static_cast<double>(FMath::Min(ConsecutiveFailures - 1, 8))), MaxProbeBackoff);
+		NextProbeTime = FPlatformTime::Seconds() + Backoff;
+		SetState(EVaultConnectionState::Offline);
+	}
+}
+
+void FVaultConnectionMonitor::SetState(EVaultConnectionState NewState)
+{
+	if (NewState == State)
+	{
+		return;
+	}
+
+	const bool bWasOffline = State == EVaultConnectionState::Offline;
+	State = NewState;
+
+	UE_LOG(LogVault, Display, TEXT("Asset library connection: %s"),
+		NewState == EVaultConnectionState::Connected ? TEXT("connected") :
+		NewState == EVaultConnectionState::Degraded ? TEXT("slow") :
+		NewState == EVaultConnectionState::Offline ? TEXT("offline") : TEXT("unknown"));
+
+	OnStateChanged.Broadcast(NewState);
+
+	// Whatever changed while we couldn't see the library.
+	if (bWasOffline && IsReachable())
+	{
+		FVaultModule::Get().RequestLibraryRefresh(false);
+	}
+}
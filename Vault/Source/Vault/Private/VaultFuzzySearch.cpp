@@ -0,0 +1,174 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultFuzzySearch.h"
+
+const int32 FVaultFuzzySearch::DefaultMaxResults = 200;
+
+namespace VaultFuzzySearchUtils
+{
+	// How much a match in each field counts, relative to the pack name.
+	static const float PackNameWeight = 1.0f;
+	static const float TagWeight = 0.7f;
+	static const float AuthorWeight = 0.5f;
+	static const float DescriptionWeight = 0.4f;
+
+	// Descriptions can be long, matches further in than this aren't worth the time.
+	static const int32 MaxFieldLength = 512;
+
+	// Rows scored between looks at the cancel flag.
+	static const int32 RowsPerCancelCheck = 64;
+
+	// 1 for an exact match, falling with every edit. Fields not much longer than the query score a bit higher,
+	// so "Rock" ranks above "Rocky Cliffs Megapack" for "rock".
+	static float ScoreField(const FString& Query, const FString& Field, int32 MaxEdits, float Weight)
+	{
+		const int32 Edits = FVaultFuzzySearch::GetSubstringEditDistance(Query, Field, MaxEdits);
+		if (Edits > MaxEdits)
+		{
+			return 0.f;
+		}
+
+		const float Closeness = 1.f - static_cast<float>(Edits) / (MaxEdits + 1);
+		const float Coverage = static_cast<float>(Query.Len()) / FMath::Max(Field.Len(), Query.Len());
+		return Weight * (Closeness + 0.25f * Coverage);
+	}
+}
+
+int32 FVaultFuzzySearch::GetMaxEdits(int32 QueryLength)
+{
+	return QueryLength <= 4 ? 1 : QueryLength <= 8 ? 2 : 3;
+}
+
+int32 FVaultFuzzySearch::GetSubstringEditDistance(const FString& Query, const FString& Text, int32 MaxEdits)
+{
+	const int32 QueryLength = Query.Len();
+	const int32 TextLength = FMath::Min(Text.Len(), VaultFuzzySearchUtils::MaxFieldLength);
+
+	// Column by column over the text. A match may start anywhere, so the top row is all zeros.
+	TArray<int32, TInlineAllocator<64>> Column;
+	Column.SetNumUninitialized(QueryLength + 1);
+	for (int32 Row = 0; Row <= QueryLength; Row++)
+	{
+		Column[Row] = Row;
+	}
+
+	int32 Best = Column[QueryLength];
+
+	for (int32 TextIndex = 0; TextIndex < TextLength && Best > 0; TextIndex++)
+	{
+		const TCHAR TextChar = FChar::ToLower(Text[TextIndex]);
+
+		int32 Diagonal = Column[0];
+		Column[0] = 0;
+
+		for (int32 Row = 1; Row <= QueryLength; Row++)
+		{
+			const int32 Above = Column[Row];
+			const int32 Substitution = Diagonal + (FChar::ToLower(Query[Row - 1]) == TextChar ? 0 : 1);
+			Column[Row] = FMath::Min3(Substitution, Above + 1, Column[Row - 1] + 1);
+			Diagonal = Above;
+		}
+
+		Best = FMath::Min(Best, Column[QueryLength]);
+	}
+
+	return FMath::Min(Best, MaxEdits + 1);
+}
+
+bool FVaultFuzzySearch::Search(const FVaultLibrarySnapshot& Library, const FString& Query, bool bNameOnly, const FVaultRowSet& AllowedRows, int32 MaxResults, TArray<int32>& OutRows, const FThreadSafeBool& bCancelled)
+{
+	using namespace VaultFuzzySearchUtils;
+
+	OutRows.Reset();
+
+	if (Query.Len() < FVaultTrigramIndex::MinQueryLength)
+	{
+		return false;
+	}
+
+	// Every edit breaks at most three of the query's trigrams and two of its bigrams, anything within reach still shares the rest.
+	const int32 MaxEdits = GetMaxEdits(Query.Len());
+	const int32 MinSharedTrigrams = FVaultTrigramIndex::CountDistinctTrigrams(Query) - 3 * MaxEdits;
+	const int32 MinSharedBigrams = FVaultTrigramIndex::CountDistinctBigrams(Query) - 2 * MaxEdits;
+
+	// Queries too short to be sure of sharing a trigram only search pack names and tags, the bigram lists don't cover the
+	// other fields.
+	const bool bKeywordsOnly = MinSharedTrigrams <= 0;
+
+	TArray<int32> CandidateRows;
+	if (!bKeywordsOnly)
+	{
+		Library.SearchIndex->FindRowsSharingTrigrams(Query, bNameOnly, MinSharedTrigrams, Library.Assets.Num(), CandidateRows, &bCancelled);
+	}
+	else if (MinSharedBigrams > 0)
+	{
+		Library.SearchIndex->FindRowsSharingBigrams(Query, bNameOnly, MinSharedBigrams, Library.Assets.Num(), CandidateRows, &bCancelled);
+	}
+	else
+	{
+		// Three and five character queries can be within reach of a match without sharing any bigram, "rck" has none
+		// in common with "rock". Nothing can be ruled out for them, so every allowed row's name and tags get scored.
+		AllowedRows.GetRows(CandidateRows);
+	}
+
+	TArray<TPair<float, int32>> ScoredRows;
+
+	for (int32 Index = 0; Index < CandidateRows.Num(); Index++)
+	{
+		if (Index % RowsPerCancelCheck == 0 && bCancelled)
+		{
+			return true;
+		}
+
+		const int32 Row = CandidateRows[Index];
+		if (!AllowedRows.Contains(Row))
+		{
+			continue;
+		}
+
+		const FVaultMetadata& Meta = Library.Assets[Row];
+
+		float Score = ScoreField(Query, Meta.PackName.ToString(), MaxEdits, PackNameWeight);
+
+		if (!bNameOnly)
+		{
+			for (const FString& Tag : Meta.Tags)
+			{
+				Score = FMath::Max(Score, ScoreField(Query, Tag, MaxEdits, TagWeight));
+			}
+			if (!bKeywordsOnly)
+			{
+				Score = FMath::Max(Score, ScoreField(Query, Meta.Author.ToString(), MaxEdits, AuthorWeight));
+				Score = FMath::Max(Score, ScoreField(Query, Meta.Description, MaxEdits, DescriptionWeight));
+			}
+		}
+
+		if (Score > 0.f)
+		{
+			ScoredRows.Emplace(Score, Row);
+		}
+	}
+
+	if (bCancelled)
+	{
+		return true;
+	}
+
+	ScoredRows.Sort([&Library](const TPair<float, int32>& A, const TPair<float, int32>& B)
+	{
+		if (A.Key != B.Key)
+		{
+			return A.Key > B.Key;
+		}
+		return Library.Assets[A.Value].PackName.LexicalLess(Library.Assets[B.Value].PackName);
+	});
+
+	const int32 NumResults = FMath::Min(ScoredRows.Num(), MaxResults);
+	OutRows.Reserve(NumResults);
+	for (int32 Index = 0; Index < NumResults; Index++)
+	{
+		OutRows.Add(ScoredRows[Index].Value);
+	}
+
+	return true;
+}
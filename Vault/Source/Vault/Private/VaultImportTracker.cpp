@@ -0,0 +1,209 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultImportTracker.h"
+#include "Vault.h"
+#include "VaultTypes.h"
+
+#include "AssetRegistryModule.h"
+#include "Containers/Ticker.h"
+#include "FileHelpers.h"
+#include "UObject/MetaData.h"
+#include "UObject/Package.h"
+
+const FName FVaultImportTracker::FileIdTag = TEXT("VaultFileId");
+const FName FVaultImportTracker::LastModifiedTag = TEXT("VaultLastModified");
+
+const float FVaultImportTracker::SettleSeconds = 0.25f;
+
+FVaultImportTracker::~FVaultImportTracker()
+{
+	Stop();
+}
+
+void FVaultImportTracker::Start()
+{
+	Stop();
+
+	// Package metadata only shows up as registry tags for keys that are asked for.
+	UObject::GetMetaDataTagsForAssetRegistry().Add(FileIdTag);
+	UObject::GetMetaDataTagsForAssetRegistry().Add(LastModifiedTag);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	AssetAddedHandle = AssetRegistry.OnAssetAdded().AddRaw(this, &FVaultImportTracker::OnAssetAdded);
+	AssetRemovedHandle = AssetRegistry.OnAssetRemoved().AddRaw(this, &FVaultImportTracker::OnAssetRemoved);
+	AssetRenamedHandle = AssetRegistry.OnAssetRenamed().AddRaw(this, &FVaultImportTracker::OnAssetRenamed);
+
+	// While the initial scan runs, every asset it finds comes through OnAssetAdded.
+	if (!AssetRegistry.IsLoadingAssets())
+	{
+		TArray<FAssetData> AllAssets;
+		AssetRegistry.GetAllAssets(AllAssets);
+
+		for (const FAssetData& AssetData : AllAssets)
+		{
+			OnAssetAdded(AssetData);
+		}
+	}
+}
+
+void FVaultImportTracker::Stop()
+{
+	if (FlushHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(FlushHandle);
+		FlushHandle.Reset();
+	}
+
+	// The registry may already be gone during editor shutdown.
+	if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>("AssetRegistry"))
+	{
+		IAssetRegistry& AssetRegistry = AssetRegistryModule->Get();
+		AssetRegistry.OnAssetAdded().Remove(AssetAddedHandle);
+		AssetRegistry.OnAssetRemoved().Remove(AssetRemovedHandle);
+		AssetRegistry.OnAssetRenamed().Remove(AssetRenamedHandle);
+	}
+
+	AssetAddedHandle.Reset();
+	AssetRemovedHandle.Reset();
+	AssetRenamedHandle.Reset();
+
+	ImportedPacks.Empty();
+	FileIdsByObjectPath.Empty();
+}
+
+void FVaultImportTracker::TagImportedAssets(const FVaultMetadata& Pack, const TArray<FAssetData>& ImportedAssets)
+{
+	TArray<UPackage*> Packages;
+
+	for (const FAssetData& AssetData : ImportedAssets)
+	{
+		UObject* Asset = AssetData.GetAsset();
+		if (!Asset)
+		{
+			continue;
+		}
+
+		UPackage* Package = Asset->GetOutermost();
+		UMetaData* MetaData = Package->GetMetaData();
+		MetaData->SetValue(Asset, FileIdTag, *Pack.FileId.ToString());
+		MetaData->SetValue(Asset, LastModifiedTag, *Pack.LastModified.ToIso8601());
+		Package->SetDirtyFlag(true);
+		Packages.AddUnique(Package);
+
+		// The registry sees the tags once the packages are saved, don't wait for it.
+		AddAsset(AssetData.ObjectPath, Pack.FileId, Pack.LastModified);
+	}
+
+	if (Packages.Num() > 0 && !UEditorLoadingAndSavingUtils::SavePackages(Packages, false))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to save the imported assets of %s, the import won't be tracked after a restart."), *Pack.PackName.ToString());
+	}
+}
+
+bool FVaultImportTracker::FindImportedPack(FName FileId, FDateTime& OutLastModified, bool& bOutAssetsPresent) const
+{
+	const FImportedPack* ImportedPack = ImportedPacks.Find(FileId);
+	if (!ImportedPack)
+	{
+		return false;
+	}
+
+	OutLastModified = ImportedPack->LastModified;
+	bOutAssetsPresent = ImportedPack->NumAssets > 0;
+	return true;
+}
+
+void FVaultImportTracker::OnAssetAdded(const FAssetData& AssetData)
+{
+	FString FileId;
+	if (!AssetData.GetTagValue(FileIdTag, FileId) || FileId.IsEmpty())
+	{
+		return;
+	}
+
+	FString LastModifiedString;
+	FDateTime LastModified;
+	if (!AssetData.GetTagValue(LastModifiedTag, LastModifiedString) || !FDateTime::ParseIso8601(*LastModifiedString, LastModified))
+	{
+		return;
+	}
+
+	AddAsset(AssetData.ObjectPath, FName(*FileId), LastModified);
+}
+
+void FVaultImportTracker::OnAssetRemoved(const FAssetData& AssetData)
+{
+	RemoveAsset(AssetData.ObjectPath);
+}
+
+void FVaultImportTracker::OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+	// The pack is still in the project, only the path we know the asset by changed.
+	FName FileId;
+	if (FileIdsByObjectPath.RemoveAndCopyValue(FName(*OldObjectPath), FileId))
+	{
+		FileIdsByObjectPath.Add(AssetData.ObjectPath, FileId);
+	}
+}
+
+void FVaultImportTracker::AddAsset(FName ObjectPath, FName FileId, const FDateTime& LastModified)
+{
+	// Re-importing a pack tags the same assets again.
+	if (const FName* KnownFileId = FileIdsByObjectPath.Find(ObjectPath))
+	{
+		if (*KnownFileId == FileId)
+		{
+			FImportedPack& ImportedPack = ImportedPacks.FindChecked(FileId);
+			if (ImportedPack.LastModified != LastModified)
+			{
+				ImportedPack.LastModified = FMath::Max(ImportedPack.LastModified, LastModified);
+				MarkChanged();
+			}
+			return;
+		}
+		RemoveAsset(ObjectPath);
+	}
+
+	FileIdsByObjectPath.Add(ObjectPath, FileId);
+
+	FImportedPack& ImportedPack = ImportedPacks.FindOrAdd(FileId);
+	ImportedPack.LastModified = ImportedPack.NumAssets > 0 ? FMath::Max(ImportedPack.LastModified, LastModified) : LastModified;
+	ImportedPack.NumAssets++;
+
+	MarkChanged();
+}
+
+void FVaultImportTracker::RemoveAsset(FName ObjectPath)
+{
+	FName FileId;
+	if (!FileIdsByObjectPath.RemoveAndCopyValue(ObjectPath, FileId))
+	{
+		return;
+	}
+
+	if (FImportedPack* ImportedPack = ImportedPacks.Find(FileId))
+	{
+		ImportedPack->NumAssets--;
+	}
+
+	MarkChanged();
+}
+
+void FVaultImportTracker::MarkChanged()
+{
+	// Imports and folder moves arrive as one event per asset, update the badges once they are through.
+	if (!FlushHandle.IsValid())
+	{
+		FlushHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FVaultImportTracker::FlushChanges), SettleSeconds);
+	}
+}
+
+bool FVaultImportTracker::FlushChanges(float DeltaTime)
+{
+	FlushHandle.Reset();
+
+	FVaultModule::Get().RefreshProjectVersions();
+
+	return false;
+}
@@ -0,0 +1,157 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryCache.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+#include "VaultLibraryIndex.h"
+
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/FileManager.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/MemoryWriter.h"
+
+const uint32 FVaultLibraryCache::CacheVersion = 1;
+
+// "VLCC"
+static const uint32 VaultLibraryCacheMagic = 0x43434C56;
+
+namespace VaultLibraryCacheUtils
+{
+	static FCriticalSection SaveLock;
+	static bool bSaveInFlight = false;
+	static FVaultLibrarySnapshotPtr PendingSnapshot;
+}
+
+FString FVaultLibraryCache::GetCacheFilePath(const FString& LibraryRoot)
+{
+	FString NormalizedRoot = LibraryRoot;
+	FPaths::NormalizeDirectoryName(NormalizedRoot);
+	return FVaultSettings::LibraryCacheFolderFull / FString::Printf(TEXT("Library-%08x.vaultidx"), FCrc::StrCrc32(*NormalizedRoot.ToLower()));
+}
+
+TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> FVaultLibraryCache::Load(const FString& LibraryRoot)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<uint8> CacheBytes;
+	if (LibraryRoot.IsEmpty() || !FFileHelper::LoadFileToArray(CacheBytes, *GetCacheFilePath(LibraryRoot), FILEREAD_Silent))
+	{
+		return nullptr;
+	}
+
+	FBufferReader Reader(CacheBytes.GetData(), CacheBytes.Num(), false);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString CachedLibraryRoot;
+	Reader << Magic;
+	Reader << Version;
+
+	if (Reader.IsError() || Magic != VaultLibraryCacheMagic || Version != CacheVersion)
+	{
+		return nullptr;
+	}
+
+	// Only a hash of the root picks the file, make sure it is really ours.
+	Reader << CachedLibraryRoot;
+	if (Reader.IsError() || CachedLibraryRoot != LibraryRoot)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FVaultLibrarySnapshot, ESPMode::ThreadSafe>();
+	Snapshot->LibraryRoot = LibraryRoot;
+
+	if (!FVaultLibraryIndex::LoadIndex(Reader, Snapshot->Assets, Snapshot->MetaFileStats))
+	{
+		return nullptr;
+	}
+
+	for (FVaultMetadata& Meta : Snapshot->Assets)
+	{
+		Meta.InternStrings();
+	}
+
+	UE_LOG(LogVault, Display, TEXT("Loaded %d packs from the local library cache in %.2f ms."), Snapshot->Assets.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	return Snapshot;
+}
+
+void FVaultLibraryCache::SaveAsync(const FVaultLibrarySnapshotPtr& Snapshot)
+{
+	using namespace VaultLibraryCacheUtils;
+
+	if (!Snapshot.IsValid())
+	{
+		return;
+	}
+
+	{
+		FScopeLock Lock(&SaveLock);
+		PendingSnapshot = Snapshot;
+		if (bSaveInFlight)
+		{
+			return;
+		}
+		bSaveInFlight = true;
+	}
+
+	Async(EAsyncExecution::ThreadPool, []()
+	{
+		while (true)
+		{
+			FVaultLibrarySnapshotPtr ToSave;
+			{
+				FScopeLock Lock(&SaveLock);
+				ToSave = MoveTemp(PendingSnapshot);
+				PendingSnapshot.Reset();
+				if (!ToSave.IsValid())
+				{
+					bSaveInFlight = false;
+					return;
+				}
+			}
+
+			Save(*ToSave);
+		}
+	});
+}
+
+bool FVaultLibraryCache::Save(const FVaultLibrarySnapshot& Snapshot)
+{
+	TArray<uint8> CacheBytes;
+	FMemoryWriter Writer(CacheBytes);
+
+	uint32 Magic = VaultLibraryCacheMagic;
+	uint32 Version = CacheVersion;
+	FString LibraryRoot = Snapshot.LibraryRoot;
+	Writer << Magic;
+	Writer << Version;
+	Writer << LibraryRoot;
+
+	FVaultLibraryIndex::SaveIndex(Writer, Snapshot.Assets, Snapshot.MetaFileStats);
+
+	// Swapped in like the library index, so a crash mid-write leaves the old cache rather than half a new one.
+	// The temp file is unique, several editors on this machine may save the same library's cache at once.
+	const FString CachePath = GetCacheFilePath(Snapshot.LibraryRoot);
+	const FString TempPath = CachePath + TEXT(".tmp") + FGuid::NewGuid().ToString();
+
+	if (!FFileHelper::SaveArrayToFile(CacheBytes, *TempPath))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to write library cache: %s"), *TempPath);
+		return false;
+	}
+
+	if (!IFileManager::Get().Move(*CachePath, *TempPath, true, true))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to replace library cache: %s"), *CachePath);
+		IFileManager::Get().Delete(*TempPath, false, true, true);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,610 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryIndex.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+#include "VaultLibraryLayout.h"
+
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "Async/MappedFileHandle.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/MemoryWriter.h"
+
+const FString FVaultLibraryIndex::IndexFilename = TEXT("Library.vaultidx");
+
+const uint32 FVaultLibraryIndex::IndexVersion = 2;
+
+// "VIDX"
+static const uint32 VaultIndexMagic = 0x58444956;
+
+namespace VaultLibraryIndexUtils
+{
+	// Builds the shared string table used for authors and tags.
+	struct FStringTableWriter
+	{
+		TArray<FString> Strings;
+		TMap<FString, int32> StringToIndex;
+
+		int32 Add(const FString& InString)
+		{
+			if (const int32* Existing = StringToIndex.Find(InString))
+			{
+				return *Existing;
+			}
+			const int32 NewIndex = Strings.Add(InString);
+			StringToIndex.Add(InString, NewIndex);
+			return NewIndex;
+		}
+	};
+
+	// Any count read back from the file can never be larger than the file itself, this catches truncated or corrupt indices early.
+	static bool IsCountValid(const FArchive& Ar, int32 Count)
+	{
+		return Count >= 0 && Count <= Ar.TotalSize();
+	}
+
+	// An empty .meta file claims a FileId for a publish in progress. One this old was left behind by a crashed editor.
+	static const double StaleClaimHours = 24.0;
+
+	// How long to wait for another user's update of a shard index, and when a lock counts as left behind by a crashed editor.
+	static const double LockTimeoutSeconds = 5.0;
+	static const double LockRetrySeconds = 0.05;
+	static const double StaleLockSeconds = 30.0;
+
+	/**
+	 * Held while a shard index is read, changed and written back, so two users updating the same shard never drop each
+	 * other's records. The lock is a file next to the index, created exclusively, which also works across machines.
+	 */
+	class FScopedIndexLock
+	{
+	public:
+		explicit FScopedIndexLock(const FString& Directory)
+			: LockPath(FVaultLibraryIndex::GetIndexFilePath(Directory) + TEXT(".lock"))
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			while (!FVaultLibraryLayout::CreateFileExclusive(LockPath))
+			{
+				// Nobody holds a lock this long, whoever created it is gone.
+				const FDateTime LockTime = IFileManager::Get().GetTimeStamp(*LockPath);
+				if (LockTime != FDateTime::MinValue() && (FDateTime::UtcNow() - LockTime).GetTotalSeconds() > StaleLockSeconds)
+				{
+					UE_LOG(LogVault, Warning, TEXT("Removing stale library index lock: %s"), *LockPath);
+					IFileManager::Get().Delete(*LockPath, false, true, true);
+					continue;
+				}
+
+				if (FPlatformTime::Seconds() - StartTime >= LockTimeoutSeconds)
+				{
+					UE_LOG(LogVault, Warning, TEXT("Unable to lock library index: %s"), *LockPath);
+					return;
+				}
+
+				FPlatformProcess::Sleep(LockRetrySeconds);
+			}
+
+			bLocked = true;
+		}
+
+		~FScopedIndexLock()
+		{
+			if (bLocked)
+			{
+				IFileManager::Get().Delete(*LockPath, false, true, true);
+			}
+		}
+
+		bool IsLocked() const { return bLocked; }
+
+	private:
+		FString LockPath;
+		bool bLocked = false;
+	};
+}
+
+FString FVaultLibraryIndex::GetIndexFilePath(const FString& Directory)
+{
+	return Directory / IndexFilename;
+}
+
+void FVaultLibraryIndex::GatherMetaFileStats(const FString& LibraryRoot, TMap<FName, FVaultMetaFileStat>& OutStats, TMap<FString, FDateTime>* OutDirectoryTimes,
+	const TMap<FString, FDateTime>* KnownDirectoryTimes, const TMap<FName, FVaultMetaFileStat>* KnownStats)
+{
+	OutStats.Empty();
+	if (OutDirectoryTimes)
+	{
+		OutDirectoryTimes->Empty();
+	}
+
+	TSet<FString> UnchangedDirectories;
+
+	for (const FString& Directory : FVaultLibraryLayout::GetPackDirectories(LibraryRoot))
+	{
+		// Taken before the listing. Whatever lands in the directory while it is listed moves it on, and gets it listed next time.
+		const FDateTime DirectoryTime = OutDirectoryTimes ? IFileManager::Get().GetStatData(*Directory).ModificationTime : FDateTime();
+		if (OutDirectoryTimes)
+		{
+			OutDirectoryTimes->Add(Directory, DirectoryTime);
+		}
+
+		const FDateTime* KnownTime = KnownDirectoryTimes && KnownStats ? KnownDirectoryTimes->Find(Directory) : nullptr;
+		if (KnownTime && *KnownTime == DirectoryTime && DirectoryTime != FDateTime::MinValue())
+		{
+			UnchangedDirectories.Add(Directory);
+			continue;
+		}
+
+		GatherMetaFileStatsInDirectory(Directory, OutStats);
+	}
+
+	if (UnchangedDirectories.Num() > 0)
+	{
+		for (const TPair<FName, FVaultMetaFileStat>& Known : *KnownStats)
+		{
+			if (UnchangedDirectories.Contains(FVaultLibraryLayout::GetPackDirectory(LibraryRoot, Known.Key)))
+			{
+				OutStats.Add(Known.Key, Known.Value);
+			}
+		}
+
+		UE_LOG(LogVault, Verbose, TEXT("Skipped listing %d unchanged pack directories."), UnchangedDirectories.Num());
+	}
+}
+
+void FVaultLibraryIndex::GatherMetaFileStatsInDirectory(const FString& Directory, TMap<FName, FVaultMetaFileStat>& OutStats)
+{
+	class FMetaFileStatVisitor : public IPlatformFile::FDirectoryStatVisitor
+	{
+	public:
+		FMetaFileStatVisitor(TMap<FName, FVaultMetaFileStat>& InStats)
+			: Stats(InStats)
+		{}
+
+		TMap<FName, FVaultMetaFileStat>& Stats;
+		TArray<FString> StaleClaims;
+
+		virtual bool Visit(const TCHAR* FilenameOrDirectory, const FFileStatData& StatData) override
+		{
+			if (!StatData.bIsDirectory && FPaths::GetExtension(FilenameOrDirectory) == TEXT("meta"))
+			{
+				// Claimed FileIds aren't packs yet, there is nothing to parse.
+				if (StatData.FileSize == 0)
+				{
+					if ((FDateTime::UtcNow() - StatData.ModificationTime).GetTotalHours() > VaultLibraryIndexUtils::StaleClaimHours)
+					{
+						StaleClaims.Add(FilenameOrDirectory);
+					}
+					return true;
+				}
+
+				FVaultMetaFileStat& Stat = Stats.Add(FName(*FPaths::GetBaseFilename(FilenameOrDirectory)));
+				Stat.Size = StatData.FileSize;
+				Stat.ModificationTime = StatData.ModificationTime;
+			}
+			return true;
+		}
+	};
+
+	FMetaFileStatVisitor Visitor(OutStats);
+	IFileManager::Get().IterateDirectoryStat(*Directory, Visitor);
+
+	for (const FString& StaleClaim : Visitor.StaleClaims)
+	{
+		UE_LOG(LogVault, Display, TEXT("Removing abandoned FileId claim: %s"), *StaleClaim);
+		IFileManager::Get().Delete(*StaleClaim, false, true, true);
+	}
+}
+
+bool FVaultLibraryIndex::ReadIndex(const FString& LibraryRoot, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats)
+{
+	OutMetadata.Empty();
+	OutStats.Empty();
+
+	if (LibraryRoot.IsEmpty())
+	{
+		return false;
+	}
+
+	// Every shard has its own index. A shard that has none yet reads as empty, its packs show up as changed and get parsed.
+	bool bReadAll = true;
+
+	for (const FString& Directory : FVaultLibraryLayout::GetPackDirectories(LibraryRoot))
+	{
+		TArray<FVaultMetadata> ShardMetadata;
+		TMap<FName, FVaultMetaFileStat> ShardStats;
+
+		if (ReadIndexFile(Directory, ShardMetadata, ShardStats))
+		{
+			OutMetadata.Append(MoveTemp(ShardMetadata));
+			OutStats.Append(MoveTemp(ShardStats));
+		}
+		else
+		{
+			bReadAll = false;
+		}
+	}
+
+	return bReadAll;
+}
+
+bool FVaultLibraryIndex::ReadIndexFile(const FString& Directory, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats)
+{
+	const FString IndexPath = GetIndexFilePath(Directory);
+
+	if (Directory.IsEmpty() || !FPaths::FileExists(IndexPath))
+	{
+		return false;
+	}
+
+	// Memory-map the index where possible, it saves copying the whole file into a buffer first.
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedHandle(PlatformFile.OpenMapped(*IndexPath));
+	if (MappedHandle.IsValid())
+	{
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedHandle->MapRegion());
+		if (MappedRegion.IsValid())
+		{
+			FBufferReader Reader(const_cast<uint8*>(MappedRegion->GetMappedPtr()), MappedRegion->GetMappedSize(), false);
+			return LoadIndex(Reader, OutMetadata, OutStats);
+		}
+	}
+
+	TArray<uint8> IndexBytes;
+	if (!FFileHelper::LoadFileToArray(IndexBytes, *IndexPath))
+	{
+		return false;
+	}
+
+	FBufferReader Reader(IndexBytes.GetData(), IndexBytes.Num(), false);
+	return LoadIndex(Reader, OutMetadata, OutStats);
+}
+
+bool FVaultLibraryIndex::WriteIndex(const FString& LibraryRoot, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats, const TSet<FString>* OnlyDirectories)
+{
+	if (LibraryRoot.IsEmpty())
+	{
+		return false;
+	}
+
+	// Split the records by the directory their files live in. Directories without records still get written, so their index empties.
+	TMap<FString, TArray<int32>> RecordsByDirectory;
+	if (OnlyDirectories)
+	{
+		for (const FString& Directory : *OnlyDirectories)
+		{
+			RecordsByDirectory.Add(Directory);
+		}
+	}
+	else
+	{
+		for (const FString& Directory : FVaultLibraryLayout::GetPackDirectories(LibraryRoot))
+		{
+			RecordsByDirectory.Add(Directory);
+		}
+	}
+
+	for (int32 RecordIndex = 0; RecordIndex < Metadata.Num(); RecordIndex++)
+	{
+		const FString Directory = FVaultLibraryLayout::GetPackDirectory(LibraryRoot, Metadata[RecordIndex].FileId);
+		TArray<int32>* Records = OnlyDirectories ? RecordsByDirectory.Find(Directory) : &RecordsByDirectory.FindOrAdd(Directory);
+		if (Records)
+		{
+			Records->Add(RecordIndex);
+		}
+	}
+
+	bool bWroteAll = true;
+
+	for (const TPair<FString, TArray<int32>>& Directory : RecordsByDirectory)
+	{
+		TArray<FVaultMetadata> DirectoryMetadata;
+		TMap<FName, FVaultMetaFileStat> DirectoryStats;
+		DirectoryMetadata.Reserve(Directory.Value.Num());
+		DirectoryStats.Reserve(Directory.Value.Num());
+
+		for (const int32 RecordIndex : Directory.Value)
+		{
+			const FVaultMetadata& Entry = Metadata[RecordIndex];
+			DirectoryMetadata.Add(Entry);
+			if (const FVaultMetaFileStat* Stat = Stats.Find(Entry.FileId))
+			{
+				DirectoryStats.Add(Entry.FileId, *Stat);
+			}
+		}
+
+		// A shard we can't lock is left as it is, its packs show up as changed and get written on a later refresh.
+		const VaultLibraryIndexUtils::FScopedIndexLock Lock(Directory.Key);
+		bWroteAll &= Lock.IsLocked() && WriteIndexFile(Directory.Key, DirectoryMetadata, DirectoryStats);
+	}
+
+	return bWroteAll;
+}
+
+bool FVaultLibraryIndex::WriteIndexFile(const FString& Directory, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats)
+{
+	if (Directory.IsEmpty())
+	{
+		return false;
+	}
+
+	TArray<uint8> IndexBytes;
+	FMemoryWriter Writer(IndexBytes);
+	SaveIndex(Writer, Metadata, Stats);
+
+	// Write next to the index and swap it in, so other users never read a half written file.
+	// The temp file is unique, two machines writing the same shard must not write into each other's file.
+	const FString IndexPath = GetIndexFilePath(Directory);
+	const FString TempPath = IndexPath + TEXT(".tmp") + FGuid::NewGuid().ToString();
+
+	if (!FFileHelper::SaveArrayToFile(IndexBytes, *TempPath))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to write library index: %s"), *TempPath);
+		return false;
+	}
+
+	if (!IFileManager::Get().Move(*IndexPath, *TempPath, true, true))
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to replace library index: %s"), *IndexPath);
+		IFileManager::Get().Delete(*TempPath, false, true, true);
+		return false;
+	}
+
+	return true;
+}
+
+bool FVaultLibraryIndex::AddOrUpdateEntry(const FVaultMetadata& Metadata)
+{
+	const FString LibraryRoot = FVaultSettings::Get().GetAssetLibraryRoot();
+	const FString Directory = FVaultLibraryLayout::GetPackDirectory(LibraryRoot, Metadata.FileId);
+
+	// Someone else may be updating the same shard, their record must survive ours.
+	const VaultLibraryIndexUtils::FScopedIndexLock Lock(Directory);
+	if (!Lock.IsLocked())
+	{
+		return false;
+	}
+
+	TArray<FVaultMetadata> IndexedMetadata;
+	TMap<FName, FVaultMetaFileStat> IndexedStats;
+
+	// No index yet, it will be built from the .meta files on the next library refresh.
+	if (!ReadIndexFile(Directory, IndexedMetadata, IndexedStats))
+	{
+		return false;
+	}
+
+	const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(LibraryRoot, Metadata.FileId, TEXT("meta"));
+	const FFileStatData StatData = IFileManager::Get().GetStatData(*MetaFilePath);
+
+	if (!StatData.bIsValid)
+	{
+		return false;
+	}
+
+	const int32 ExistingIndex = IndexedMetadata.IndexOfByPredicate([&Metadata](const FVaultMetadata& Entry)
+	{
+		return Entry.FileId == Metadata.FileId;
+	});
+
+	if (ExistingIndex != INDEX_NONE)
+	{
+		IndexedMetadata[ExistingIndex] = Metadata;
+	}
+	else
+	{
+		IndexedMetadata.Add(Metadata);
+	}
+
+	FVaultMetaFileStat& Stat = IndexedStats.FindOrAdd(Metadata.FileId);
+	Stat.Size = StatData.FileSize;
+	Stat.ModificationTime = StatData.ModificationTime;
+
+	return WriteIndexFile(Directory, IndexedMetadata, IndexedStats);
+}
+
+bool FVaultLibraryIndex::RemoveEntry(FName FileId)
+{
+	const FString Directory = FVaultLibraryLayout::GetPackDirectory(FVaultSettings::Get().GetAssetLibraryRoot(), FileId);
+
+	const VaultLibraryIndexUtils::FScopedIndexLock Lock(Directory);
+	if (!Lock.IsLocked())
+	{
+		return false;
+	}
+
+	TArray<FVaultMetadata> IndexedMetadata;
+	TMap<FName, FVaultMetaFileStat> IndexedStats;
+
+	if (!ReadIndexFile(Directory, IndexedMetadata, IndexedStats))
+	{
+		return false;
+	}
+
+	IndexedMetadata.RemoveAll([FileId](const FVaultMetadata& Entry)
+	{
+		return Entry.FileId == FileId;
+	});
+	IndexedStats.Remove(FileId);
+
+	return WriteIndexFile(Directory, IndexedMetadata, IndexedStats);
+}
+
+void FVaultLibraryIndex::SaveIndex(FArchive& Ar, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats)
+{
+	VaultLibraryIndexUtils::FStringTableWriter StringTable;
+
+	// Gather the string table first, it is written ahead of the records.
+	for (const FVaultMetadata& Entry : Metadata)
+	{
+		StringTable.Add(Entry.Author.ToString());
+		for (const FString& Tag : Entry.Tags)
+		{
+			StringTable.Add(Tag);
+		}
+	}
+
+	uint32 Magic = VaultIndexMagic;
+	uint32 Version = IndexVersion;
+	Ar << Magic;
+	Ar << Version;
+
+	int32 NumStrings = StringTable.Strings.Num();
+	Ar << NumStrings;
+	for (FString& String : StringTable.Strings)
+	{
+		Ar << String;
+	}
+
+	int32 NumRecords = Metadata.Num();
+	Ar << NumRecords;
+
+	for (const FVaultMetadata& Entry : Metadata)
+	{
+		FString FileId = Entry.FileId.ToString();
+		FString PackName = Entry.PackName.ToString();
+		FString Description = Entry.Description;
+		FString MachineID = Entry.MachineID;
+		int32 AuthorIndex = StringTable.Add(Entry.Author.ToString());
+		uint8 Category = Entry.Category.GetValue();
+		int64 CreationTicks = Entry.CreationDate.GetTicks();
+		int64 ModifiedTicks = Entry.LastModified.GetTicks();
+		int32 HierarchyBadness = Entry.HierarchyBadness;
+
+		Ar << FileId;
+		Ar << PackName;
+		Ar << AuthorIndex;
+		Ar << Description;
+		Ar << Category;
+		Ar << CreationTicks;
+		Ar << ModifiedTicks;
+		Ar << MachineID;
+		Ar << HierarchyBadness;
+
+		int32 NumTags = Entry.Tags.Num();
+		Ar << NumTags;
+		for (const FString& Tag : Entry.Tags)
+		{
+			int32 TagIndex = StringTable.Add(Tag);
+			Ar << TagIndex;
+		}
+
+		const FVaultMetaFileStat* Stat = Stats.Find(Entry.FileId);
+		int64 StatSize = Stat ? Stat->Size : -1;
+		int64 StatTicks = Stat ? Stat->ModificationTime.GetTicks() : 0;
+		Ar << StatSize;
+		Ar << StatTicks;
+	}
+}
+
+bool FVaultLibraryIndex::LoadIndex(FArchive& Ar, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats)
+{
+	OutMetadata.Empty();
+	OutStats.Empty();
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != VaultIndexMagic || Version != IndexVersion)
+	{
+		UE_LOG(LogVault, Display, TEXT("Library index has an unknown format, it will be rebuilt."));
+		return false;
+	}
+
+	int32 NumStrings = 0;
+	Ar << NumStrings;
+	if (!VaultLibraryIndexUtils::IsCountValid(Ar, NumStrings))
+	{
+		return false;
+	}
+
+	TArray<FString> Strings;
+	Strings.SetNum(NumStrings);
+	for (FString& String : Strings)
+	{
+		Ar << String;
+	}
+
+	int32 NumRecords = 0;
+	Ar << NumRecords;
+	if (Ar.IsError() || !VaultLibraryIndexUtils::IsCountValid(Ar, NumRecords))
+	{
+		return false;
+	}
+
+	OutMetadata.Reserve(NumRecords);
+	OutStats.Reserve(NumRecords);
+
+	for (int32 RecordIndex = 0; RecordIndex < NumRecords; RecordIndex++)
+	{
+		FString FileId;
+		FString PackName;
+		int32 AuthorIndex = INDEX_NONE;
+		uint8 Category = 0;
+		int64 CreationTicks = 0;
+		int64 ModifiedTicks = 0;
+		int32 HierarchyBadness = 0;
+
+		FVaultMetadata& Entry = OutMetadata.AddDefaulted_GetRef();
+
+		Ar << FileId;
+		Ar << PackName;
+		Ar << AuthorIndex;
+		Ar << Entry.Description;
+		Ar << Category;
+		Ar << CreationTicks;
+		Ar << ModifiedTicks;
+		Ar << Entry.MachineID;
+		Ar << HierarchyBadness;
+
+		if (Ar.IsError() || !Strings.IsValidIndex(AuthorIndex))
+		{
+			return false;
+		}
+
+		Entry.FileId = FName(*FileId);
+		Entry.PackName = FName(*PackName);
+		Entry.Author = FName(*Strings[AuthorIndex]);
+		Entry.Category = static_cast<FVaultCategory>(FMath::Min<uint8>(Category, FVaultCategory::Unknown));
+		Entry.CreationDate = FDateTime(CreationTicks);
+		Entry.LastModified = FDateTime(ModifiedTicks);
+		Entry.HierarchyBadness = HierarchyBadness;
+
+		int32 NumTags = 0;
+		Ar << NumTags;
+		if (!VaultLibraryIndexUtils::IsCountValid(Ar, NumTags))
+		{
+			return false;
+		}
+		Entry.Tags.Reserve(NumTags);
+		for (int32 TagIndex = 0; TagIndex < NumTags; TagIndex++)
+		{
+			int32 StringIndex = INDEX_NONE;
+			Ar << StringIndex;
+			if (!Strings.IsValidIndex(StringIndex))
+			{
+				return false;
+			}
+			Entry.Tags.Add(Strings[StringIndex]);
+		}
+
+		// Object lists are left out to keep the index small, they are read from the .meta file when a pack is opened.
+		Entry.bDetailsLoaded = false;
+
+		int64 StatSize = -1;
+		int64 StatTicks = 0;
+		Ar << StatSize;
+		Ar << StatTicks;
+
+		FVaultMetaFileStat& Stat = OutStats.Add(Entry.FileId);
+		Stat.Size = StatSize;
+		Stat.ModificationTime = FDateTime(StatTicks);
+	}
+
+	return !Ar.IsError();
+}
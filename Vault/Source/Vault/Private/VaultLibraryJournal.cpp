@@ -0,0 +1,274 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryJournal.h"
+#include "Vault.h"
+
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+
+const FString FVaultLibraryJournal::JournalFilename = TEXT("Library.journal");
+
+const int64 FVaultLibraryJournal::MaxJournalSize = 1024 * 1024;
+
+namespace VaultLibraryJournalUtils
+{
+	// The header is fixed size, so record offsets never depend on the base generation.
+	static const ANSICHAR HeaderPrefix[] = "VaultJournal1 ";
+	static const int32 HeaderPrefixLen = UE_ARRAY_COUNT(HeaderPrefix) - 1;
+	static const int32 HeaderSize = HeaderPrefixLen + 20 + 1;
+
+	static FString MakeHeader(uint64 BaseGeneration)
+	{
+		return FString::Printf(TEXT("VaultJournal1 %020llu\n"), BaseGeneration);
+	}
+
+	// A fresh journal starts at the current time rather than 0. Generations handed out by a journal that was deleted or
+	// broken are then always behind it, and their readers rescan instead of replaying from the middle of a record.
+	static uint64 MakeFreshBaseGeneration()
+	{
+		return static_cast<uint64>(FDateTime::UtcNow().GetTicks());
+	}
+
+	static bool ReadHeader(FArchive& Ar, uint64& OutBaseGeneration)
+	{
+		if (Ar.TotalSize() < HeaderSize)
+		{
+			return false;
+		}
+
+		ANSICHAR Header[HeaderSize + 1] = {};
+		Ar.Seek(0);
+		Ar.Serialize(Header, HeaderSize);
+
+		if (Ar.IsError() || FCStringAnsi::Strncmp(Header, HeaderPrefix, HeaderPrefixLen) != 0 || Header[HeaderSize - 1] != '\n')
+		{
+			return false;
+		}
+
+		OutBaseGeneration = FCStringAnsi::Strtoui64(Header + HeaderPrefixLen, nullptr, 10);
+		return true;
+	}
+
+	static void WriteString(FArchive& Ar, const FString& String)
+	{
+		FTCHARToUTF8 Utf8(*String);
+		Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+	}
+
+	// Open the journal and read its header. Null if there is no journal or it is broken.
+	static TUniquePtr<FArchive> OpenJournal(const FString& LibraryRoot, uint64& OutBaseGeneration)
+	{
+		if (LibraryRoot.IsEmpty())
+		{
+			return nullptr;
+		}
+
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*(LibraryRoot / FVaultLibraryJournal::JournalFilename), FILEREAD_Silent | FILEREAD_AllowWrite));
+		if (!Reader.IsValid() || !ReadHeader(*Reader, OutBaseGeneration))
+		{
+			return nullptr;
+		}
+
+		return Reader;
+	}
+
+	// Read everything from Offset to the end of the journal.
+	static bool ReadRecords(FArchive& Ar, int64 Offset, TArray<ANSICHAR>& OutRecords)
+	{
+		OutRecords.SetNumUninitialized(static_cast<int32>(Ar.TotalSize() - Offset));
+		Ar.Seek(Offset);
+		Ar.Serialize(OutRecords.GetData(), OutRecords.Num());
+		return !Ar.IsError();
+	}
+
+	// Write a journal holding only a header, next to the journal and swapped in like the library index.
+	// The temp file is unique, users compacting at the same time must not write into each other's file.
+	static bool WriteEmptyJournal(const FString& JournalPath, uint64 BaseGeneration)
+	{
+		const FString TempPath = JournalPath + TEXT(".tmp") + FGuid::NewGuid().ToString();
+
+		if (!FFileHelper::SaveStringToFile(MakeHeader(BaseGeneration), *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to write library journal: %s"), *TempPath);
+			return false;
+		}
+
+		if (!IFileManager::Get().Move(*JournalPath, *TempPath, true, true))
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to replace library journal: %s"), *JournalPath);
+			IFileManager::Get().Delete(*TempPath, false, true, true);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+FString FVaultLibraryJournal::GetJournalFilePath(const FString& LibraryRoot)
+{
+	return LibraryRoot / JournalFilename;
+}
+
+const TCHAR* FVaultLibraryJournal::OpToString(EVaultJournalOp Op)
+{
+	switch (Op)
+	{
+	case EVaultJournalOp::Publish: return TEXT("publish");
+	case EVaultJournalOp::Update: return TEXT("update");
+	case EVaultJournalOp::Rename: return TEXT("rename");
+	case EVaultJournalOp::Delete: return TEXT("delete");
+	}
+	return TEXT("unknown");
+}
+
+bool FVaultLibraryJournal::Append(const FString& LibraryRoot, EVaultJournalOp Op, FName FileId)
+{
+	if (LibraryRoot.IsEmpty() || FileId.IsNone())
+	{
+		return false;
+	}
+
+	const FString JournalPath = GetJournalFilePath(LibraryRoot);
+
+	bool bHasValidHeader = false;
+	int64 JournalSize = 0;
+	{
+		uint64 BaseGeneration = 0;
+		TUniquePtr<FArchive> Reader = VaultLibraryJournalUtils::OpenJournal(LibraryRoot, BaseGeneration);
+		if (Reader.IsValid())
+		{
+			bHasValidHeader = true;
+			JournalSize = Reader->TotalSize();
+		}
+	}
+
+	// No journal yet, or one we can't make sense of. Start over, readers of the old one rescan.
+	if (!bHasValidHeader && !VaultLibraryJournalUtils::WriteEmptyJournal(JournalPath, VaultLibraryJournalUtils::MakeFreshBaseGeneration()))
+	{
+		return false;
+	}
+
+	// One write per record, so readers never see more than the last record half written.
+	const FString Record = FString::Printf(TEXT("%s %s\n"), OpToString(Op), *FileId.ToString());
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*JournalPath, FILEWRITE_Append | FILEWRITE_AllowRead));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to append to library journal: %s"), *JournalPath);
+		return false;
+	}
+
+	VaultLibraryJournalUtils::WriteString(*Writer, Record);
+	const bool bWritten = Writer->Close();
+
+	if (!bWritten)
+	{
+		UE_LOG(LogVault, Warning, TEXT("Unable to append to library journal: %s"), *JournalPath);
+		return false;
+	}
+
+	if (JournalSize + Record.Len() > MaxJournalSize)
+	{
+		Compact(LibraryRoot);
+	}
+
+	return true;
+}
+
+uint64 FVaultLibraryJournal::GetEndGeneration(const FString& LibraryRoot)
+{
+	using namespace VaultLibraryJournalUtils;
+
+	uint64 BaseGeneration = 0;
+	TUniquePtr<FArchive> Reader = OpenJournal(LibraryRoot, BaseGeneration);
+	if (!Reader.IsValid())
+	{
+		return 0;
+	}
+
+	TArray<ANSICHAR> Records;
+	if (!ReadRecords(*Reader, HeaderSize, Records))
+	{
+		return 0;
+	}
+
+	int32 CompleteBytes = Records.Num();
+	while (CompleteBytes > 0 && Records[CompleteBytes - 1] != '\n')
+	{
+		CompleteBytes--;
+	}
+
+	return BaseGeneration + CompleteBytes;
+}
+
+bool FVaultLibraryJournal::Compact(const FString& LibraryRoot)
+{
+	if (LibraryRoot.IsEmpty())
+	{
+		return false;
+	}
+
+	const uint64 EndGeneration = GetEndGeneration(LibraryRoot);
+	const uint64 BaseGeneration = EndGeneration > 0 ? EndGeneration : VaultLibraryJournalUtils::MakeFreshBaseGeneration();
+
+	UE_LOG(LogVault, Display, TEXT("Compacting library journal of %s."), *LibraryRoot);
+
+	// Records appended by others between reading the end and swapping the file in are lost. Their packs still
+	// get picked up by the directory watcher, or by the rescan of anyone who was behind.
+	return VaultLibraryJournalUtils::WriteEmptyJournal(GetJournalFilePath(LibraryRoot), BaseGeneration);
+}
+
+FVaultLibraryJournal::EReadResult FVaultLibraryJournal::ReadSince(const FString& LibraryRoot, uint64 Generation, TSet<FName>& OutFileIds, uint64& OutEndGeneration)
+{
+	using namespace VaultLibraryJournalUtils;
+
+	OutFileIds.Empty();
+	OutEndGeneration = Generation;
+
+	uint64 BaseGeneration = 0;
+	TUniquePtr<FArchive> Reader = OpenJournal(LibraryRoot, BaseGeneration);
+	if (!Reader.IsValid())
+	{
+		return EReadResult::Unavailable;
+	}
+
+	// Behind the base, or past the end of a journal that was replaced since.
+	const int64 RecordBytes = Reader->TotalSize() - HeaderSize;
+	if (Generation < BaseGeneration || Generation - BaseGeneration > static_cast<uint64>(RecordBytes))
+	{
+		return EReadResult::Compacted;
+	}
+
+	TArray<ANSICHAR> Tail;
+	if (!ReadRecords(*Reader, HeaderSize + static_cast<int64>(Generation - BaseGeneration), Tail))
+	{
+		return EReadResult::Unavailable;
+	}
+
+	// Records are "<op> <FileId>\n". A last record without its newline is still being written, it is read next time.
+	int32 LineStart = 0;
+	for (int32 Position = 0; Position < Tail.Num(); Position++)
+	{
+		if (Tail[Position] != '\n')
+		{
+			continue;
+		}
+
+		int32 Separator = LineStart;
+		while (Separator < Position && Tail[Separator] != ' ')
+		{
+			Separator++;
+		}
+
+		if (Separator + 1 < Position)
+		{
+			const FUTF8ToTCHAR FileId(Tail.GetData() + Separator + 1, Position - Separator - 1);
+			OutFileIds.Add(FName(FileId.Length(), FileId.Get()));
+		}
+
+		LineStart = Position + 1;
+	}
+
+	OutEndGeneration = Generation + LineStart;
+	return EReadResult::Ok;
+}
@@ -0,0 +1,216 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryLayout.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+#include "VaultLibraryIndex.h"
+#include "VaultLibraryJournal.h"
+#include "MetadataOps.h"
+
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Crc.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const FString FVaultLibraryLayout::ShardedMarkerFilename = TEXT("Library.sharded");
+
+const int32 FVaultLibraryLayout::NumShards = 256;
+
+// Layout of every library root we have looked at. Checking the marker file is a round trip to the share, so we only do it on a full rescan.
+static FRWLock LayoutCacheLock;
+static TMap<FString, bool> ShardedLibraryRoots;
+
+static FAutoConsoleCommand MigrateLibraryToShardsCommand(
+	TEXT("Vault.MigrateLibraryToShards"),
+	TEXT("Move every pack of the asset library into shard directories. Run it while nobody is publishing."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		if (FVaultLibraryLayout::MigrateToSharded(FVaultSettings::Get().GetAssetLibraryRoot()))
+		{
+			FVaultModule::Get().RequestLibraryRefresh();
+		}
+	}));
+
+bool FVaultLibraryLayout::IsSharded(const FString& LibraryRoot)
+{
+	{
+		FReadScopeLock ReadLock(LayoutCacheLock);
+		if (const bool* bSharded = ShardedLibraryRoots.Find(LibraryRoot))
+		{
+			return *bSharded;
+		}
+	}
+	return DetectLayout(LibraryRoot);
+}
+
+bool FVaultLibraryLayout::DetectLayout(const FString& LibraryRoot)
+{
+	const bool bSharded = !LibraryRoot.IsEmpty() && FPaths::FileExists(LibraryRoot / ShardedMarkerFilename);
+
+	FWriteScopeLock WriteLock(LayoutCacheLock);
+	ShardedLibraryRoots.Add(LibraryRoot, bSharded);
+	return bSharded;
+}
+
+FString FVaultLibraryLayout::GetShardName(FName FileId)
+{
+	// FileIds are made from pack names, so their first characters are far from evenly spread. Hash them instead.
+	// FNames compare case insensitive, the hash has to as well.
+	const uint32 Hash = FCrc::StrCrc32(*FileId.ToString().ToLower());
+	return FString::Printf(TEXT("%02x"), Hash % NumShards);
+}
+
+FString FVaultLibraryLayout::GetPackDirectory(const FString& LibraryRoot, FName FileId)
+{
+	return IsSharded(LibraryRoot) ? LibraryRoot / GetShardName(FileId) : LibraryRoot;
+}
+
+FString FVaultLibraryLayout::GetPackFilePath(const FString& LibraryRoot, FName FileId, const TCHAR* Extension)
+{
+	return GetPackDirectory(LibraryRoot, FileId) / FileId.ToString() + TEXT(".") + Extension;
+}
+
+TArray<FString> FVaultLibraryLayout::GetPackDirectories(const FString& LibraryRoot)
+{
+	TArray<FString> Directories;
+
+	if (!IsSharded(LibraryRoot))
+	{
+		Directories.Add(LibraryRoot);
+		return Directories;
+	}
+
+	TArray<FString> Subdirectories;
+	IFileManager::Get().FindFiles(Subdirectories, *(LibraryRoot / TEXT("*")), false, true);
+	Subdirectories.Sort();
+
+	for (const FString& Subdirectory : Subdirectories)
+	{
+		// Ignore anything else people keep next to the shards.
+		if (Subdirectory.Len() == 2 && FChar::IsHexDigit(Subdirectory[0]) && FChar::IsHexDigit(Subdirectory[1]))
+		{
+			Directories.Add(LibraryRoot / Subdirectory);
+		}
+	}
+
+	return Directories;
+}
+
+bool FVaultLibraryLayout::CreateFileExclusive(const FString& Path)
+{
+#if PLATFORM_WINDOWS
+	HANDLE Handle = CreateFileW(*Path, GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (Handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	CloseHandle(Handle);
+	return true;
+#else
+	const int FileDescriptor = open(TCHAR_TO_UTF8(*Path), O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (FileDescriptor < 0)
+	{
+		return false;
+	}
+	close(FileDescriptor);
+	return true;
+#endif
+}
+
+bool FVaultLibraryLayout::MigrateToSharded(const FString& LibraryRoot)
+{
+	if (LibraryRoot.IsEmpty() || !FPaths::DirectoryExists(LibraryRoot))
+	{
+		UE_LOG(LogVault, Error, TEXT("Unable to migrate the asset library, %s can't be reached."), *LibraryRoot);
+		return false;
+	}
+
+	if (DetectLayout(LibraryRoot))
+	{
+		UE_LOG(LogVault, Display, TEXT("Asset library %s is already sharded."), *LibraryRoot);
+		return true;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(LibraryRoot / TEXT("*")), true, false);
+
+	int32 NumMoved = 0;
+	int32 NumFailed = 0;
+
+	for (const FString& Filename : Filenames)
+	{
+		const FString Extension = FPaths::GetExtension(Filename);
+		if (Extension != TEXT("meta") && Extension != TEXT("upack") && Extension != TEXT("png"))
+		{
+			continue;
+		}
+
+		const FName FileId = FName(*FPaths::GetBaseFilename(Filename));
+		const FString TargetPath = LibraryRoot / GetShardName(FileId) / Filename;
+
+		if (IFileManager::Get().Move(*TargetPath, *(LibraryRoot / Filename), false, true))
+		{
+			NumMoved++;
+		}
+		else
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to move %s to %s"), *Filename, *TargetPath);
+			NumFailed++;
+		}
+	}
+
+	// Without the marker the library still reads as flat, so running the migration again picks up where this one stopped.
+	if (NumFailed > 0)
+	{
+		UE_LOG(LogVault, Error, TEXT("Migrating the asset library failed for %d files. Fix the access to them and run Vault.MigrateLibraryToShards again."), NumFailed);
+		return false;
+	}
+
+	if (!FFileHelper::SaveStringToFile(FString::Printf(TEXT("Shards=%d"), NumShards), *(LibraryRoot / ShardedMarkerFilename)))
+	{
+		UE_LOG(LogVault, Error, TEXT("Unable to write %s to the asset library."), *ShardedMarkerFilename);
+		return false;
+	}
+
+	DetectLayout(LibraryRoot);
+
+	// Give every shard its index right away, the first rescan would otherwise see no changes and never write them.
+	TMap<FName, FVaultMetaFileStat> Stats;
+	FVaultLibraryIndex::GatherMetaFileStats(LibraryRoot, Stats);
+
+	TArray<FString> MetaFilepaths;
+	MetaFilepaths.Reserve(Stats.Num());
+	for (const TPair<FName, FVaultMetaFileStat>& Stat : Stats)
+	{
+		MetaFilepaths.Add(GetPackFilePath(LibraryRoot, Stat.Key, TEXT("meta")));
+	}
+
+	TArray<FVaultMetadata> Metadata = FMetadataOps::ReadMetadataFiles(MetaFilepaths, true, true);
+	Metadata.RemoveAll([](const FVaultMetadata& Meta)
+	{
+		return !Meta.IsMetaValid();
+	});
+	FVaultLibraryIndex::WriteIndex(LibraryRoot, Metadata, Stats);
+
+	IFileManager::Get().Delete(*FVaultLibraryIndex::GetIndexFilePath(LibraryRoot), false, true, true);
+
+	// Every pack path changed, nobody can catch up on this by replaying the journal.
+	FVaultLibraryJournal::Compact(LibraryRoot);
+
+	UE_LOG(LogVault, Display, TEXT("Migrated asset library %s to %d shards: moved %d files in %.1fs."),
+		*LibraryRoot, NumShards, NumMoved, FPlatformTime::Seconds() - StartTime);
+
+	return true;
+}
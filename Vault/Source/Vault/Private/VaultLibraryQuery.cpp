@@ -0,0 +1,597 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryQuery.h"
+#include "VaultStringDictionary.h"
+
+#include "Algo/BinarySearch.h"
+
+namespace VaultLibraryQueryUtils
+{
+	// Keys the query understands. FNames compare case-insensitive, so Tag: works as well.
+	static const FName NameKeys[] = { TEXT("name"), TEXT("pack") };
+	static const FName TagKeys[] = { TEXT("tag"), TEXT("tags") };
+	static const FName AuthorKeys[] = { TEXT("author"), TEXT("dev"), TEXT("developer") };
+	static const FName CategoryKeys[] = { TEXT("category"), TEXT("cat"), TEXT("type") };
+	static const FName DescriptionKeys[] = { TEXT("description"), TEXT("desc") };
+	static const FName CreatedKeys[] = { TEXT("created") };
+	static const FName ModifiedKeys[] = { TEXT("modified"), TEXT("updated") };
+
+	template <int32 NumKeys>
+	static bool IsKey(const FName& Key, const FName (&Keys)[NumKeys])
+	{
+		for (const FName& Name : Keys)
+		{
+			if (Key == Name)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static bool IsNameKey(const FName& Key) { return IsKey(Key, NameKeys); }
+	static bool IsTagKey(const FName& Key) { return IsKey(Key, TagKeys); }
+	static bool IsAuthorKey(const FName& Key) { return IsKey(Key, AuthorKeys); }
+	static bool IsCategoryKey(const FName& Key) { return IsKey(Key, CategoryKeys); }
+	static bool IsDescriptionKey(const FName& Key) { return IsKey(Key, DescriptionKeys); }
+	static bool IsCreatedKey(const FName& Key) { return IsKey(Key, CreatedKeys); }
+	static bool IsModifiedKey(const FName& Key) { return IsKey(Key, ModifiedKeys); }
+
+	static bool HasWildcard(const FString& Value)
+	{
+		int32 Index;
+		return Value.FindChar(TEXT('*'), Index) || Value.FindChar(TEXT('?'), Index);
+	}
+
+	/**
+	 * Ticks in [OutMin, OutMax) satisfying "date Operation Value". A date without a time covers the whole day,
+	 * so modified>2026-01-01 starts the day after. False for values that aren't dates and for NotEqual.
+	 */
+	static bool GetTickRange(const FString& Value, ETextFilterComparisonOperation Operation, int64& OutMin, int64& OutMax)
+	{
+		FDateTime Date;
+		if (!FDateTime::ParseIso8601(*Value, Date))
+		{
+			return false;
+		}
+
+		int32 TimeIndex;
+		const int64 Start = Date.GetTicks();
+		const int64 End = Start + (Value.FindChar(TEXT('T'), TimeIndex) ? 1 : ETimespan::TicksPerDay);
+
+		OutMin = MIN_int64;
+		OutMax = MAX_int64;
+
+		switch (Operation)
+		{
+		case ETextFilterComparisonOperation::Equal:
+			OutMin = Start;
+			OutMax = End;
+			return true;
+		case ETextFilterComparisonOperation::Less:
+			OutMax = Start;
+			return true;
+		case ETextFilterComparisonOperation::LessOrEqual:
+			OutMax = End;
+			return true;
+		case ETextFilterComparisonOperation::Greater:
+			OutMin = End;
+			return true;
+		case ETextFilterComparisonOperation::GreaterOrEqual:
+			OutMin = Start;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static bool TestDate(const FDateTime& Date, const FString& Value, ETextFilterComparisonOperation Operation)
+	{
+		const bool bNegate = Operation == ETextFilterComparisonOperation::NotEqual;
+
+		int64 Min, Max;
+		if (!GetTickRange(Value, bNegate ? ETextFilterComparisonOperation::Equal : Operation, Min, Max))
+		{
+			return false;
+		}
+
+		const int64 Ticks = Date.GetTicks();
+		return (Ticks >= Min && Ticks < Max) != bNegate;
+	}
+
+	// Tag terms match when any tag does. "tag!=wip" means no tag is wip, not that some tag isn't.
+	static bool TestTags(const TSet<FString>& Tags, const FTextFilterString& Value, ETextFilterComparisonOperation Operation, ETextFilterTextComparisonMode Mode)
+	{
+		const bool bNegate = Operation == ETextFilterComparisonOperation::NotEqual;
+		const ETextFilterComparisonOperation TagOperation = bNegate ? ETextFilterComparisonOperation::Equal : Operation;
+
+		for (const FString& Tag : Tags)
+		{
+			if (TextFilterUtils::TestComplexExpression(Tag, Value, TagOperation, Mode))
+			{
+				return !bNegate;
+			}
+		}
+		return bNegate;
+	}
+
+	// Rows in Sorted, ordered by Ticks, whose ticks lie in [Min, Max).
+	static void GetRowsInTickRange(const TArray<int32>& Sorted, const TArray<int64>& Ticks, int64 Min, int64 Max, FVaultRowSet& OutRows)
+	{
+		const int32 First = Algo::LowerBoundBy(Sorted, Min, [&Ticks](int32 Row) { return Ticks[Row]; });
+		const int32 Last = Algo::LowerBoundBy(Sorted, Max, [&Ticks](int32 Row) { return Ticks[Row]; });
+		for (int32 Index = First; Index < Last; Index++)
+		{
+			OutRows.Add(Sorted[Index]);
+		}
+	}
+
+	// Split at whitespace outside of quotes.
+	static void Tokenize(const FString& Text, TArray<FString>& OutTokens)
+	{
+		FString Token;
+		bool bInQuotes = false;
+
+		for (const TCHAR Char : Text)
+		{
+			if (Char == TEXT('"'))
+			{
+				bInQuotes = !bInQuotes;
+			}
+			if (!bInQuotes && FChar::IsWhitespace(Char))
+			{
+				if (!Token.IsEmpty())
+				{
+					OutTokens.Add(MoveTemp(Token));
+					Token.Reset();
+				}
+				continue;
+			}
+			Token.AppendChar(Char);
+		}
+
+		if (!Token.IsEmpty())
+		{
+			OutTokens.Add(MoveTemp(Token));
+		}
+	}
+
+	static FString Unquote(const FString& Value)
+	{
+		FString Result = Value.TrimStartAndEnd();
+		if (Result.Len() >= 2 && Result.StartsWith(TEXT("\"")) && Result.EndsWith(TEXT("\"")))
+		{
+			Result = Result.Mid(1, Result.Len() - 2);
+		}
+		return Result;
+	}
+}
+
+/** One row of a library snapshot as seen by the evaluator. */
+class FLibraryRowFilterContext : public ITextFilterExpressionContext
+{
+public:
+
+	FLibraryRowFilterContext(const FVaultMetadata& InMeta, bool bInNameOnly)
+		: Meta(InMeta)
+		, bNameOnly(bInNameOnly)
+	{
+	}
+
+	virtual bool TestBasicStringExpression(const FTextFilterString& InValue, const ETextFilterTextComparisonMode InTextComparisonMode) const override
+	{
+		if (TextFilterUtils::TestBasicStringExpression(Meta.PackName.ToString(), InValue, InTextComparisonMode))
+		{
+			return true;
+		}
+
+		if (bNameOnly)
+		{
+			return false;
+		}
+
+		if (TextFilterUtils::TestBasicStringExpression(Meta.Author.ToString(), InValue, InTextComparisonMode)
+			|| TextFilterUtils::TestBasicStringExpression(Meta.Description, InValue, InTextComparisonMode))
+		{
+			return true;
+		}
+
+		for (const FString& Tag : Meta.Tags)
+		{
+			if (TextFilterUtils::TestBasicStringExpression(Tag, InValue, InTextComparisonMode))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	virtual bool TestComplexExpression(const FName& InKey, const FTextFilterString& InValue, const ETextFilterComparisonOperation InComparisonOperation, const ETextFilterTextComparisonMode InTextComparisonMode) const override
+	{
+		using namespace VaultLibraryQueryUtils;
+
+		if (IsNameKey(InKey))
+		{
+			return TextFilterUtils::TestComplexExpression(Meta.PackName.ToString(), InValue, InComparisonOperation, InTextComparisonMode);
+		}
+		if (IsTagKey(InKey))
+		{
+			return TestTags(Meta.Tags, InValue, InComparisonOperation, InTextComparisonMode);
+		}
+		if (IsAuthorKey(InKey))
+		{
+			return TextFilterUtils::TestComplexExpression(Meta.Author.ToString(), InValue, InComparisonOperation, InTextComparisonMode);
+		}
+		if (IsCategoryKey(InKey))
+		{
+			return TextFilterUtils::TestComplexExpression(FVaultMetadata::CategoryToString(Meta.Category), InValue, InComparisonOperation, InTextComparisonMode);
+		}
+		if (IsDescriptionKey(InKey))
+		{
+			return TextFilterUtils::TestComplexExpression(Meta.Description, InValue, InComparisonOperation, InTextComparisonMode);
+		}
+		if (IsCreatedKey(InKey))
+		{
+			return TestDate(Meta.CreationDate, InValue.AsString(), InComparisonOperation);
+		}
+		if (IsModifiedKey(InKey))
+		{
+			return TestDate(Meta.LastModified, InValue.AsString(), InComparisonOperation);
+		}
+		return false;
+	}
+
+private:
+
+	const FVaultMetadata& Meta;
+	bool bNameOnly;
+};
+
+FVaultLibraryQuery::FVaultLibraryQuery()
+	: Evaluator(MakeShareable(new FTextFilterExpressionEvaluator(ETextFilterExpressionEvaluatorMode::Complex)))
+{
+}
+
+bool FVaultLibraryQuery::IsStructured(const FString& QueryText)
+{
+	int32 Index;
+	for (const TCHAR Char : { TEXT(':'), TEXT('='), TEXT('<'), TEXT('>'), TEXT('"'), TEXT('('), TEXT(')') })
+	{
+		if (QueryText.FindChar(Char, Index))
+		{
+			return true;
+		}
+	}
+
+	TArray<FString> Tokens;
+	VaultLibraryQueryUtils::Tokenize(QueryText, Tokens);
+	for (const FString& Token : Tokens)
+	{
+		if (Token.StartsWith(TEXT("-")) || Token.StartsWith(TEXT("!"))
+			|| Token.Equals(TEXT("AND"), ESearchCase::CaseSensitive) || Token.Equals(TEXT("OR"), ESearchCase::CaseSensitive) || Token.Equals(TEXT("NOT"), ESearchCase::CaseSensitive)
+			|| Token == TEXT("&&") || Token == TEXT("||"))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FVaultLibraryQuery::SetQuery(const FString& InQueryText, bool bInNameOnly)
+{
+	using namespace VaultLibraryQueryUtils;
+
+	QueryText = InQueryText;
+	bNameOnly = bInNameOnly;
+	Evaluator->SetFilterText(FText::FromString(QueryText));
+	Plan.Reset();
+
+	if (!Evaluator->GetFilterErrorText().IsEmpty())
+	{
+		return false;
+	}
+
+	TArray<FString> Tokens;
+	Tokenize(QueryText, Tokens);
+
+	// Alternatives and groups can make any term optional, the evaluator has to look at every row then.
+	for (const FString& Token : Tokens)
+	{
+		int32 Index;
+		if (Token == TEXT("OR") || Token == TEXT("||") || Token == TEXT("|")
+			|| (!Token.StartsWith(TEXT("\"")) && (Token.FindChar(TEXT('('), Index) || Token.FindChar(TEXT(')'), Index))))
+		{
+			return true;
+		}
+	}
+
+	bool bNegateNext = false;
+	for (const FString& Token : Tokens)
+	{
+		if (Token == TEXT("AND") || Token == TEXT("&&") || Token == TEXT("&"))
+		{
+			continue;
+		}
+		if (Token == TEXT("NOT") || Token == TEXT("!") || Token == TEXT("-"))
+		{
+			bNegateNext = !bNegateNext;
+			continue;
+		}
+
+		const bool bNegated = Token.StartsWith(TEXT("-")) || Token.StartsWith(TEXT("!"));
+		AddPlanStep(bNegated ? Token.Mid(1) : Token, bNegated != bNegateNext);
+		bNegateNext = false;
+	}
+
+	// Catalog bitsets cost a pass over a few words, date ranges a binary search, trigram lookups a walk of their posting lists.
+	Plan.StableSort([](const FPlanStep& A, const FPlanStep& B)
+	{
+		auto GetCost = [](EStepKind Kind)
+		{
+			return Kind == EStepKind::Text ? 2 : (Kind == EStepKind::Created || Kind == EStepKind::Modified) ? 1 : 0;
+		};
+		return GetCost(A.Kind) < GetCost(B.Kind);
+	});
+
+	return true;
+}
+
+void FVaultLibraryQuery::AddPlanStep(FString Term, bool bNegated)
+{
+	using namespace VaultLibraryQueryUtils;
+
+	FPlanStep Step;
+	Step.bNegated = bNegated;
+	Step.Operation = ETextFilterComparisonOperation::Equal;
+
+	// The key ends at the first operator outside of quotes.
+	int32 OperatorIndex = INDEX_NONE;
+	bool bInQuotes = false;
+	for (int32 Index = 0; Index < Term.Len() && OperatorIndex == INDEX_NONE; Index++)
+	{
+		const TCHAR Char = Term[Index];
+		if (Char == TEXT('"'))
+		{
+			bInQuotes = !bInQuotes;
+		}
+		else if (!bInQuotes && (Char == TEXT(':') || Char == TEXT('=') || Char == TEXT('!') || Char == TEXT('<') || Char == TEXT('>')))
+		{
+			OperatorIndex = Index;
+		}
+	}
+
+	if (OperatorIndex == INDEX_NONE)
+	{
+		Step.Kind = EStepKind::Text;
+		Step.Value = Unquote(Term);
+		Plan.Add(Step);
+		return;
+	}
+
+	const FName Key(*Term.Left(OperatorIndex).TrimStartAndEnd());
+	const TCHAR First = Term[OperatorIndex];
+	const bool bTwoChars = OperatorIndex + 1 < Term.Len() && Term[OperatorIndex + 1] == TEXT('=');
+
+	switch (First)
+	{
+	case TEXT('!'): Step.Operation = ETextFilterComparisonOperation::NotEqual; break;
+	case TEXT('<'): Step.Operation = bTwoChars ? ETextFilterComparisonOperation::LessOrEqual : ETextFilterComparisonOperation::Less; break;
+	case TEXT('>'): Step.Operation = bTwoChars ? ETextFilterComparisonOperation::GreaterOrEqual : ETextFilterComparisonOperation::Greater; break;
+	default: break;
+	}
+
+	Step.Value = Unquote(Term.Mid(OperatorIndex + (bTwoChars ? 2 : 1)));
+
+	// "tag!=wip" rules out the same rows as "-tag:wip".
+	if (Step.Operation == ETextFilterComparisonOperation::NotEqual)
+	{
+		Step.Operation = ETextFilterComparisonOperation::Equal;
+		Step.bNegated = !Step.bNegated;
+	}
+
+	if (IsTagKey(Key))
+	{
+		Step.Kind = EStepKind::Tag;
+	}
+	else if (IsAuthorKey(Key))
+	{
+		Step.Kind = EStepKind::Author;
+	}
+	else if (IsCategoryKey(Key))
+	{
+		Step.Kind = EStepKind::Category;
+	}
+	else if (IsCreatedKey(Key))
+	{
+		Step.Kind = EStepKind::Created;
+	}
+	else if (IsModifiedKey(Key))
+	{
+		Step.Kind = EStepKind::Modified;
+	}
+	else
+	{
+		// Names and descriptions have no index of their own, the evaluator checks them.
+		return;
+	}
+
+	Plan.Add(Step);
+}
+
+bool FVaultLibraryQuery::GetStepRows(const FPlanStep& Step, const FVaultLibrarySnapshot& Library, FVaultRowSet& OutRows, const FThreadSafeBool* bCancelled) const
+{
+	using namespace VaultLibraryQueryUtils;
+
+	const FVaultLibraryCatalog& Catalog = *Library.Catalog;
+	const bool bEquality = Step.Operation == ETextFilterComparisonOperation::Equal;
+
+	if (Step.Value.IsEmpty() || HasWildcard(Step.Value))
+	{
+		return false;
+	}
+
+	// Every step has to hand back a superset of what the evaluator would accept, or the complement of a subset of what it
+	// would reject when negated. Text comparisons may be exact or partial, so matches are taken as substrings and
+	// exclusions as whole values.
+	switch (Step.Kind)
+	{
+	case EStepKind::Tag:
+	case EStepKind::Author:
+	{
+		if (!bEquality)
+		{
+			return false;
+		}
+
+		const bool bTag = Step.Kind == EStepKind::Tag;
+		const FVaultStringDictionary& Dictionary = bTag ? FVaultStringDictionary::Tags() : FVaultStringDictionary::Authors();
+		const TMap<int32, FVaultRowGroup>& RowsById = bTag ? Catalog.RowsByTagId : Catalog.RowsByAuthorId;
+
+		TArray<int32> Ids;
+		if (Step.bNegated)
+		{
+			const int32 Id = Dictionary.Find(Step.Value);
+			if (Id != INDEX_NONE)
+			{
+				Ids.Add(Id);
+			}
+		}
+		else
+		{
+			Ids = Dictionary.FindIdsContaining(Step.Value);
+		}
+
+		OutRows.Init(Catalog.Num(), false);
+		for (const int32 Id : Ids)
+		{
+			if (const FVaultRowGroup* Rows = RowsById.Find(Id))
+			{
+				Rows->AddTo(OutRows);
+			}
+		}
+		return true;
+	}
+
+	case EStepKind::Category:
+	{
+		if (!bEquality)
+		{
+			return false;
+		}
+
+		OutRows.Init(Catalog.Num(), false);
+		for (int32 Category = 0; Category < Catalog.RowsByCategory.Num(); Category++)
+		{
+			const FString CategoryName = FVaultMetadata::CategoryToString(static_cast<FVaultCategory>(Category));
+			if (Step.bNegated ? CategoryName.Equals(Step.Value, ESearchCase::IgnoreCase) : CategoryName.Contains(Step.Value))
+			{
+				OutRows.Union(Catalog.RowsByCategory[Category]);
+			}
+		}
+		return true;
+	}
+
+	case EStepKind::Created:
+	case EStepKind::Modified:
+	{
+		int64 Min, Max;
+		if (!GetTickRange(Step.Value, Step.Operation, Min, Max))
+		{
+			return false;
+		}
+
+		const bool bCreated = Step.Kind == EStepKind::Created;
+		OutRows.Init(Catalog.Num(), false);
+		GetRowsInTickRange(bCreated ? Catalog.RowsByCreationTicks : Catalog.RowsByModifiedTicks, bCreated ? Catalog.CreationTicks : Catalog.ModifiedTicks, Min, Max, OutRows);
+		return true;
+	}
+
+	case EStepKind::Text:
+	{
+		// Rows containing a word can't be told from rows the evaluator rejects, only matches can use the index.
+		TArray<int32> Candidates;
+		if (Step.bNegated || !Library.SearchIndex->FindCandidates(Step.Value, bNameOnly, Candidates, bCancelled))
+		{
+			return false;
+		}
+
+		OutRows.Init(Catalog.Num(), false);
+		for (const int32 Row : Candidates)
+		{
+			OutRows.Add(Row);
+		}
+		return true;
+	}
+	}
+
+	return false;
+}
+
+bool FVaultLibraryQuery::IsSameQuery(const FString& InQueryText, bool bInNameOnly) const
+{
+	return bInNameOnly == bNameOnly && InQueryText.Equals(QueryText, ESearchCase::CaseSensitive);
+}
+
+FText FVaultLibraryQuery::GetErrorText() const
+{
+	return Evaluator->GetFilterErrorText();
+}
+
+void FVaultLibraryQuery::GetCandidateRows(const FVaultLibrarySnapshot& Library, const FVaultRowSet& AllowedRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled) const
+{
+	OutRows.Reset();
+
+	if (!GetErrorText().IsEmpty() || AllowedRows.NumRows != Library.Assets.Num())
+	{
+		return;
+	}
+
+	FVaultRowSet Rows = AllowedRows;
+
+	// Gather the steps' row sets, cheapest first. Nothing can match once any of them comes back empty.
+	TArray<TPair<int32, FVaultRowSet>> Included;
+	for (const FPlanStep& Step : Plan)
+	{
+		if (bCancelled && *bCancelled)
+		{
+			return;
+		}
+
+		FVaultRowSet StepRows;
+		if (!GetStepRows(Step, Library, StepRows, bCancelled))
+		{
+			continue;
+		}
+
+		if (Step.bNegated)
+		{
+			Rows.Subtract(StepRows);
+			continue;
+		}
+
+		const int32 Count = StepRows.Count();
+		if (Count == 0)
+		{
+			return;
+		}
+		Included.Emplace(Count, MoveTemp(StepRows));
+	}
+
+	// Most selective first, so the running set shrinks as fast as it can.
+	Included.Sort([](const TPair<int32, FVaultRowSet>& A, const TPair<int32, FVaultRowSet>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	for (const TPair<int32, FVaultRowSet>& Step : Included)
+	{
+		Rows.Intersect(Step.Value);
+	}
+
+	Rows.GetRows(OutRows);
+}
+
+bool FVaultLibraryQuery::Matches(const FVaultLibrarySnapshot& Library, int32 Row) const
+{
+	return Evaluator->TestTextFilter(FLibraryRowFilterContext(Library.Assets[Row], bNameOnly));
+}
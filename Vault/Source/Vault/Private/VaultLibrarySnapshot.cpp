@@ -0,0 +1,466 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibrarySnapshot.h"
+#include "Vault.h"
+#include "MetadataOps.h"
+#include "VaultLibraryLayout.h"
+
+#include "HAL/FileManager.h"
+
+namespace VaultLibrarySnapshotUtils
+{
+	// Turn the row lists that take more memory than a bitset into one: four bytes per row against a bit per catalog row.
+	static void CompactRowGroups(TMap<int32, FVaultRowGroup>& Groups, int32 NumRows)
+	{
+		for (TPair<int32, FVaultRowGroup>& Group : Groups)
+		{
+			if (Group.Value.Rows.Num() * 32 > NumRows)
+			{
+				Group.Value.Set.Init(NumRows, false);
+				for (const int32 Row : Group.Value.Rows)
+				{
+					Group.Value.Set.Add(Row);
+				}
+				Group.Value.Rows.Empty();
+			}
+			else
+			{
+				Group.Value.Rows.Shrink();
+			}
+		}
+	}
+}
+
+TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> FVaultLibrarySnapshot::Build(const FVaultLibrarySnapshotPtr& Previous, const FString& LibraryRoot, const TSet<FName>* OnlyFileIds,
+	const TMap<FString, FDateTime>* KnownDirectoryTimes, TMap<FString, FDateTime>* OutDirectoryTimes)
+{
+	// Records and stats we compare against. Stats are only meaningful for the library they were gathered from.
+	TArray<FVaultMetadata> SeededAssets;
+	TMap<FName, FVaultMetaFileStat> SeededStats;
+	const TArray<FVaultMetadata>* KnownAssets = &SeededAssets;
+	const TMap<FName, FVaultMetaFileStat>* KnownStats = &SeededStats;
+
+	const bool bSameLibrary = Previous.IsValid() && Previous->LibraryRoot == LibraryRoot;
+
+	// Full rescans pick up a library that was migrated to shards since we last looked.
+	if (!bSameLibrary || !OnlyFileIds)
+	{
+		FVaultLibraryLayout::DetectLayout(LibraryRoot);
+	}
+
+	if (bSameLibrary)
+	{
+		KnownAssets = &Previous->Assets;
+		KnownStats = &Previous->MetaFileStats;
+	}
+	else
+	{
+		// Cold start, seed from the binary library index. Anything it got wrong is picked up by the stat comparison below.
+		FVaultLibraryIndex::ReadIndex(LibraryRoot, SeededAssets, SeededStats);
+
+		for (FVaultMetadata& Meta : SeededAssets)
+		{
+			Meta.InternStrings();
+		}
+
+		// Nothing to patch yet, so a targeted update turns into a full rescan.
+		OnlyFileIds = nullptr;
+	}
+
+	TMap<FName, FVaultMetaFileStat> CurrentStats;
+	TSet<FName> RemovedFileIds;
+
+	if (OnlyFileIds)
+	{
+		for (const FName& FileId : *OnlyFileIds)
+		{
+			const FString MetaFilePath = FVaultLibraryLayout::GetPackFilePath(LibraryRoot, FileId, TEXT("meta"));
+			const FFileStatData StatData = IFileManager::Get().GetStatData(*MetaFilePath);
+
+			// An empty .meta file only claims the FileId for a publish in progress, see GatherMetaFileStats.
+			if (StatData.bIsValid && !StatData.bIsDirectory && StatData.FileSize > 0)
+			{
+				FVaultMetaFileStat& Stat = CurrentStats.Add(FileId);
+				Stat.Size = StatData.FileSize;
+				Stat.ModificationTime = StatData.ModificationTime;
+			}
+			else if (KnownStats->Contains(FileId))
+			{
+				RemovedFileIds.Add(FileId);
+			}
+		}
+	}
+	else
+	{
+		// One directory listing per shard gives us size and modification time of every .meta file.
+		// Shards left as they were can only be skipped against stats that came from the same library.
+		FVaultLibraryIndex::GatherMetaFileStats(LibraryRoot, CurrentStats, OutDirectoryTimes, bSameLibrary ? KnownDirectoryTimes : nullptr, KnownStats);
+
+		for (const TPair<FName, FVaultMetaFileStat>& Known : *KnownStats)
+		{
+			if (!CurrentStats.Contains(Known.Key))
+			{
+				RemovedFileIds.Add(Known.Key);
+			}
+		}
+	}
+
+	TArray<FName> ChangedFileIds;
+	for (const TPair<FName, FVaultMetaFileStat>& Current : CurrentStats)
+	{
+		const FVaultMetaFileStat* Known = KnownStats->Find(Current.Key);
+		if (!Known || *Known != Current.Value)
+		{
+			ChangedFileIds.Add(Current.Key);
+		}
+	}
+
+	// A new library always gets a snapshot, even an empty one, so nothing keeps showing the old root.
+	if (bSameLibrary && RemovedFileIds.Num() == 0 && ChangedFileIds.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FVaultLibrarySnapshot, ESPMode::ThreadSafe>();
+	Snapshot->LibraryRoot = LibraryRoot;
+
+	if (bSameLibrary)
+	{
+		Snapshot->Assets = *KnownAssets;
+		Snapshot->MetaFileStats = *KnownStats;
+	}
+	else
+	{
+		Snapshot->Assets = MoveTemp(SeededAssets);
+		Snapshot->MetaFileStats = MoveTemp(SeededStats);
+	}
+
+	if (RemovedFileIds.Num() == 0 && ChangedFileIds.Num() == 0)
+	{
+		return Snapshot;
+	}
+
+	UE_LOG(LogVault, Display, TEXT("Library %s: %d changed, %d removed."), OnlyFileIds ? TEXT("update") : TEXT("rescan"), ChangedFileIds.Num(), RemovedFileIds.Num());
+
+	if (RemovedFileIds.Num() > 0)
+	{
+		Snapshot->Assets.RemoveAll([&RemovedFileIds](const FVaultMetadata& Meta)
+		{
+			return RemovedFileIds.Contains(Meta.FileId);
+		});
+
+		for (const FName& FileId : RemovedFileIds)
+		{
+			Snapshot->MetaFileStats.Remove(FileId);
+		}
+	}
+
+	if (ChangedFileIds.Num() > 0)
+	{
+		// Keep new packs in a stable order, the stat map comes back in file system order.
+		ChangedFileIds.Sort(FNameLexicalLess());
+
+		TArray<FString> ChangedFilepaths;
+		ChangedFilepaths.Reserve(ChangedFileIds.Num());
+		for (const FName& FileId : ChangedFileIds)
+		{
+			ChangedFilepaths.Add(FVaultLibraryLayout::GetPackFilePath(LibraryRoot, FileId, TEXT("meta")));
+			Snapshot->MetaFileStats.Add(FileId, CurrentStats.FindChecked(FileId));
+		}
+
+		// Object lists can run into the thousands per pack and are only needed once a pack is opened, see FMetadataOps::LoadDetails.
+		TArray<FVaultMetadata> ChangedMetadata = FMetadataOps::ReadMetadataFiles(ChangedFilepaths, true, true);
+
+		TMap<FName, int32> AssetIndexByFileId;
+		AssetIndexByFileId.Reserve(Snapshot->Assets.Num());
+		for (int32 AssetIndex = 0; AssetIndex < Snapshot->Assets.Num(); AssetIndex++)
+		{
+			AssetIndexByFileId.Add(Snapshot->Assets[AssetIndex].FileId, AssetIndex);
+		}
+
+		for (FVaultMetadata& Meta : ChangedMetadata)
+		{
+			// A .meta caught half written parses to nothing. It gets picked up again once the writer is done and its stat changes.
+			if (!Meta.IsMetaValid())
+			{
+				continue;
+			}
+
+			Meta.InternStrings();
+
+			if (const int32* AssetIndex = AssetIndexByFileId.Find(Meta.FileId))
+			{
+				Snapshot->Assets[*AssetIndex] = MoveTemp(Meta);
+			}
+			else
+			{
+				Snapshot->Assets.Add(MoveTemp(Meta));
+			}
+		}
+	}
+
+	// Keep the shared index in step after a full rescan, so the next editor to start up gets a current library in one read.
+	// Only the shards that changed are rewritten.
+	// Targeted updates come from somebody else's write, and whoever wrote the .meta file already updated the index.
+	if (!OnlyFileIds)
+	{
+		TSet<FString> ChangedDirectories;
+		for (const FName& FileId : ChangedFileIds)
+		{
+			ChangedDirectories.Add(FVaultLibraryLayout::GetPackDirectory(LibraryRoot, FileId));
+		}
+		for (const FName& FileId : RemovedFileIds)
+		{
+			ChangedDirectories.Add(FVaultLibraryLayout::GetPackDirectory(LibraryRoot, FileId));
+		}
+
+		FVaultLibraryIndex::WriteIndex(LibraryRoot, Snapshot->Assets, Snapshot->MetaFileStats, &ChangedDirectories);
+	}
+
+	return Snapshot;
+}
+
+const FVaultMetadata* FVaultLibrarySnapshot::FindByFileId(FName FileId) const
+{
+	const int32* Row = Catalog.IsValid() ? Catalog->RowByFileId.Find(FileId) : nullptr;
+	return Row ? &Assets[*Row] : nullptr;
+}
+
+const FVaultMetadata* FVaultLibrarySnapshot::FindByPackName(FName PackName) const
+{
+	const int32* Row = Catalog.IsValid() ? Catalog->RowByPackName.Find(PackName) : nullptr;
+	return Row ? &Assets[*Row] : nullptr;
+}
+
+void FVaultLibrarySnapshot::BuildIndices(const FVaultLibrarySnapshot* Previous)
+{
+	TSharedRef<FVaultLibraryCatalog, ESPMode::ThreadSafe> NewCatalog = MakeShared<FVaultLibraryCatalog, ESPMode::ThreadSafe>();
+	NewCatalog->Build(Assets);
+	Catalog = NewCatalog;
+
+	const FVaultTrigramIndex* PreviousSearchIndex = Previous && Previous != this ? Previous->SearchIndex.Get() : nullptr;
+	TSharedRef<FVaultTrigramIndex, ESPMode::ThreadSafe> NewSearchIndex = MakeShared<FVaultTrigramIndex, ESPMode::ThreadSafe>();
+	NewSearchIndex->Build(Assets, MetaFileStats, PreviousSearchIndex);
+	SearchIndex = NewSearchIndex;
+}
+
+void FVaultLibraryCatalog::Build(const TArray<FVaultMetadata>& Assets)
+{
+	const int32 NumRows = Assets.Num();
+
+	PackNames.Reset(NumRows);
+	Categories.Reset(NumRows);
+	AuthorIds.Reset(NumRows);
+	CreationTicks.Reset(NumRows);
+	ModifiedTicks.Reset(NumRows);
+	HierarchyBadness.Reset(NumRows);
+	TagIdOffsets.Reset(NumRows + 1);
+	TagIds.Reset();
+
+	TagIdOffsets.Add(0);
+
+	for (const FVaultMetadata& Meta : Assets)
+	{
+		PackNames.Add(Meta.PackName);
+		Categories.Add(Meta.Category.GetValue());
+		AuthorIds.Add(Meta.AuthorId);
+		CreationTicks.Add(Meta.CreationDate.GetTicks());
+		ModifiedTicks.Add(Meta.LastModified.GetTicks());
+		HierarchyBadness.Add(static_cast<int8>(FMath::Clamp(Meta.HierarchyBadness, -128, 127)));
+
+		TagIds.Append(Meta.TagIds);
+		TagIdOffsets.Add(TagIds.Num());
+	}
+
+	RowsByCategory.SetNum(FVaultCategory::Unknown + 1);
+	for (FVaultRowSet& Rows : RowsByCategory)
+	{
+		Rows.Init(NumRows, false);
+	}
+
+	RowsByTagId.Reset();
+	RowsByAuthorId.Reset();
+	RowsWithBadHierarchy.Init(NumRows, false);
+
+	// Rows are visited in order, so every list comes out sorted.
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		RowsByCategory[FMath::Min<uint8>(Categories[Row], FVaultCategory::Unknown)].Add(Row);
+
+		RowsByAuthorId.FindOrAdd(AuthorIds[Row]).Rows.Add(Row);
+
+		for (const int32 TagId : GetTagIds(Row))
+		{
+			RowsByTagId.FindOrAdd(TagId).Rows.Add(Row);
+		}
+
+		if (HierarchyBadness[Row] > 0)
+		{
+			RowsWithBadHierarchy.Add(Row);
+		}
+	}
+
+	VaultLibrarySnapshotUtils::CompactRowGroups(RowsByAuthorId, NumRows);
+	VaultLibrarySnapshotUtils::CompactRowGroups(RowsByTagId, NumRows);
+
+	RowByFileId.Reset();
+	RowByPackName.Reset();
+	RowByFileId.Reserve(NumRows);
+	RowByPackName.Reserve(NumRows);
+
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		RowByFileId.Add(Assets[Row].FileId, Row);
+		// Pack names are meant to be unique, but nothing stops two users publishing the same one. The first one wins, like the old scan.
+		if (!RowByPackName.Contains(Assets[Row].PackName))
+		{
+			RowByPackName.Add(Assets[Row].PackName, Row);
+		}
+	}
+
+	RowsByName.Reset(NumRows);
+	RowsByCreationTicks.Reset(NumRows);
+	RowsByModifiedTicks.Reset(NumRows);
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		RowsByName.Add(Row);
+		RowsByCreationTicks.Add(Row);
+		RowsByModifiedTicks.Add(Row);
+	}
+	RowsByName.StableSort([this](int32 A, int32 B) { return PackNames[A].LexicalLess(PackNames[B]); });
+	RowsByCreationTicks.StableSort([this](int32 A, int32 B) { return CreationTicks[A] < CreationTicks[B]; });
+	RowsByModifiedTicks.StableSort([this](int32 A, int32 B) { return ModifiedTicks[A] < ModifiedTicks[B]; });
+}
+
+void FVaultRowSet::Init(int32 InNumRows, bool bAllRows)
+{
+	NumRows = InNumRows;
+	Words.Init(bAllRows ? ~uint64(0) : uint64(0), (InNumRows + 63) >> 6);
+
+	// Bits past the last row stay clear, so GetRows never reports rows that don't exist.
+	if (bAllRows && (InNumRows & 63) != 0)
+	{
+		Words.Last() = (uint64(1) << (InNumRows & 63)) - 1;
+	}
+}
+
+void FVaultRowGroup::AddTo(FVaultRowSet& OutRows) const
+{
+	if (IsDense())
+	{
+		OutRows.Union(Set);
+		return;
+	}
+
+	for (const int32 Row : Rows)
+	{
+		OutRows.Add(Row);
+	}
+}
+
+void FVaultRowSet::Intersect(const FVaultRowSet& Other)
+{
+	check(Words.Num() == Other.Words.Num());
+	for (int32 Word = 0; Word < Words.Num(); Word++)
+	{
+		Words[Word] &= Other.Words[Word];
+	}
+}
+
+void FVaultRowSet::Union(const FVaultRowSet& Other)
+{
+	check(Words.Num() == Other.Words.Num());
+	for (int32 Word = 0; Word < Words.Num(); Word++)
+	{
+		Words[Word] |= Other.Words[Word];
+	}
+}
+
+void FVaultRowSet::Subtract(const FVaultRowSet& Other)
+{
+	check(Words.Num() == Other.Words.Num());
+	for (int32 Word = 0; Word < Words.Num(); Word++)
+	{
+		Words[Word] &= ~Other.Words[Word];
+	}
+}
+
+void FVaultLibraryCatalog::SortRows(TArray<int32>& Rows, SortingTypes SortingType, bool bReverse, const FThreadSafeBool* bCancelled) const
+{
+	const TArray<int32>& Order = SortingType == SortingTypes::Filename ? RowsByName : SortingType == SortingTypes::CreationDate ? RowsByCreationTicks : RowsByModifiedTicks;
+
+	// Many rows are picked out of the catalog's own order instead. That is linear and can stop at any point, a sort can't.
+	static const int32 RowsPerCancelCheck = 4096;
+	if (Rows.Num() > Num() / 16 && Order.Num() == Num())
+	{
+		FVaultRowSet Members;
+		Members.Init(Num(), false);
+		for (const int32 Row : Rows)
+		{
+			Members.Add(Row);
+		}
+
+		// Names list A to Z and dates newest first, unless reversed.
+		const bool bBackwards = (SortingType == SortingTypes::Filename) == bReverse;
+
+		Rows.Reset();
+		for (int32 Index = 0; Index < Order.Num(); Index++)
+		{
+			if (bCancelled && Index % RowsPerCancelCheck == 0 && *bCancelled)
+			{
+				return;
+			}
+
+			const int32 Row = Order[bBackwards ? Order.Num() - 1 - Index : Index];
+			if (Members.Contains(Row))
+			{
+				Rows.Add(Row);
+			}
+		}
+		return;
+	}
+
+	switch (SortingType) {
+	case SortingTypes::Filename:
+		Rows.Sort([&](const int32 a, const int32 b)
+		{
+			return bReverse ? PackNames[b].LexicalLess(PackNames[a]) : PackNames[a].LexicalLess(PackNames[b]);
+		});
+		break;
+	case SortingTypes::CreationDate:
+		Rows.Sort([&](const int32 a, const int32 b)
+		{
+			return bReverse ? CreationTicks[a] < CreationTicks[b] : CreationTicks[a] > CreationTicks[b];
+		});
+		break;
+	case SortingTypes::ModificationDate:
+		Rows.Sort([&](const int32 a, const int32 b)
+		{
+			return bReverse ? ModifiedTicks[a] < ModifiedTicks[b] : ModifiedTicks[a] > ModifiedTicks[b];
+		});
+		break;
+	}
+}
+
+int32 FVaultRowSet::Count() const
+{
+	int32 Total = 0;
+	for (const uint64 Word : Words)
+	{
+		Total += static_cast<int32>(FPlatformMath::CountBits(Word));
+	}
+	return Total;
+}
+
+void FVaultRowSet::GetRows(TArray<int32>& OutRows) const
+{
+	for (int32 Word = 0; Word < Words.Num(); Word++)
+	{
+		uint64 Bits = Words[Word];
+		while (Bits != 0)
+		{
+			OutRows.Add((Word << 6) + static_cast<int32>(FMath::CountTrailingZeros64(Bits)));
+			Bits &= Bits - 1;
+		}
+	}
+}
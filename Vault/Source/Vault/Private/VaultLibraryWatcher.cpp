@@ -0,0 +1,208 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLibraryWatcher.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+#include "VaultLibraryLayout.h"
+
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#include "Misc/Paths.h"
+
+const double FVaultLibraryWatcher::CoalesceSeconds = 0.5;
+const double FVaultLibraryWatcher::MaxCoalesceSeconds = 3.0;
+const double FVaultLibraryWatcher::StatRescanInterval = 300.0;
+
+// How often the ticker checks for settled events and due polls.
+static const float WatcherTickInterval = 0.25f;
+
+FVaultLibraryWatcher::~FVaultLibraryWatcher()
+{
+	Stop();
+}
+
+void FVaultLibraryWatcher::Start(const FString& InLibraryRoot)
+{
+	Stop();
+
+	if (InLibraryRoot.IsEmpty())
+	{
+		return;
+	}
+
+	LibraryRoot = InLibraryRoot;
+
+	// A hung share would hang the registration, and the game thread with it. Only register once a probe got through.
+	FVaultConnectionMonitor& ConnectionMonitor = FVaultConnectionMonitor::Get();
+	if (ConnectionMonitor.GetState() == EVaultConnectionState::Connected)
+	{
+		RegisterNotifications();
+	}
+	else
+	{
+		ConnectionStateHandle = ConnectionMonitor.OnStateChanged.AddRaw(this, &FVaultLibraryWatcher::OnConnectionStateChanged);
+	}
+
+	UpdatePollInterval();
+
+	UE_LOG(LogVault, Display, TEXT("Watching asset library %s (notifications: %s, polling every %.0fs)"),
+		*LibraryRoot, bIsWatching ? TEXT("yes") : TEXT("waiting for the share"), PollInterval);
+
+	LastPollTime = FPlatformTime::Seconds();
+	LastStatRescanTime = LastPollTime;
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FVaultLibraryWatcher::Tick), WatcherTickInterval);
+}
+
+void FVaultLibraryWatcher::RegisterNotifications()
+{
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+
+	if (DirectoryWatcher)
+	{
+		bIsWatching = DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(
+			LibraryRoot,
+			IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FVaultLibraryWatcher::OnDirectoryChanged),
+			WatcherHandle);
+	}
+}
+
+void FVaultLibraryWatcher::UpdatePollInterval()
+{
+	// Some shares (cloud drives, some SMB setups) accept the registration but never send anything, so we keep polling as a safety net.
+	PollInterval = FVaultSettings::Get().GetLibraryPollingInterval();
+	if (!bIsWatching && PollInterval <= 0.0)
+	{
+		PollInterval = FVaultSettings::DefaultLibraryPollingInterval;
+	}
+}
+
+void FVaultLibraryWatcher::OnConnectionStateChanged(EVaultConnectionState State)
+{
+	if (State != EVaultConnectionState::Connected || bIsWatching || LibraryRoot.IsEmpty())
+	{
+		return;
+	}
+
+	FVaultConnectionMonitor::Get().OnStateChanged.Remove(ConnectionStateHandle);
+	ConnectionStateHandle.Reset();
+
+	RegisterNotifications();
+	UpdatePollInterval();
+
+	UE_LOG(LogVault, Display, TEXT("Asset library %s reached (notifications: %s, polling every %.0fs)"),
+		*LibraryRoot, bIsWatching ? TEXT("yes") : TEXT("no"), PollInterval);
+}
+
+void FVaultLibraryWatcher::Stop()
+{
+	if (ConnectionStateHandle.IsValid())
+	{
+		FVaultConnectionMonitor::Get().OnStateChanged.Remove(ConnectionStateHandle);
+		ConnectionStateHandle.Reset();
+	}
+
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	if (bIsWatching)
+	{
+		// The watcher module may already be gone during editor shutdown.
+		if (FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+		{
+			if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+			{
+				DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(LibraryRoot, WatcherHandle);
+			}
+		}
+		bIsWatching = false;
+	}
+
+	WatcherHandle.Reset();
+	PendingFileIds.Empty();
+	PendingThumbnailFileIds.Empty();
+	bLayoutChanged = false;
+	LibraryRoot.Empty();
+}
+
+void FVaultLibraryWatcher::OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	for (const FFileChangeData& Change : FileChanges)
+	{
+		// Somebody migrated the library, every pack path changes.
+		if (FPaths::GetCleanFilename(Change.Filename) == FVaultLibraryLayout::ShardedMarkerFilename)
+		{
+			bLayoutChanged = true;
+			continue;
+		}
+
+		const FString Extension = FPaths::GetExtension(Change.Filename);
+		const bool bIsThumbnail = Extension == TEXT("png");
+
+		if (Extension != TEXT("meta") && Extension != TEXT("upack") && !bIsThumbnail)
+		{
+			continue;
+		}
+
+		const FName FileId = FName(*FPaths::GetBaseFilename(Change.Filename));
+
+		if (PendingFileIds.Num() == 0)
+		{
+			FirstPendingEventTime = Now;
+		}
+		LastPendingEventTime = Now;
+
+		PendingFileIds.Add(FileId);
+		if (bIsThumbnail)
+		{
+			PendingThumbnailFileIds.Add(FileId);
+		}
+	}
+}
+
+bool FVaultLibraryWatcher::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (PendingFileIds.Num() > 0)
+	{
+		const bool bSettled = Now - LastPendingEventTime >= CoalesceSeconds;
+		const bool bWaitedTooLong = Now - FirstPendingEventTime >= MaxCoalesceSeconds;
+
+		if (bSettled || bWaitedTooLong)
+		{
+			const TSet<FName> FileIds = MoveTemp(PendingFileIds);
+			const TSet<FName> ThumbnailFileIds = MoveTemp(PendingThumbnailFileIds);
+			PendingFileIds.Reset();
+			PendingThumbnailFileIds.Reset();
+
+			// The thumbnails are copied by the refresh task, the share is never touched from the ticker.
+			FVaultModule::Get().RequestPackRefresh(FileIds, ThumbnailFileIds);
+
+			// Anything a poll would find has just been picked up.
+			LastPollTime = Now;
+		}
+	}
+
+	// Records lost to a racing compaction, appends that didn't make it over SMB, older plugin versions and hand-edited
+	// .meta files never show up in the journal. A migration may still be compacting it as well.
+	if (bLayoutChanged || Now - LastStatRescanTime >= StatRescanInterval)
+	{
+		FVaultModule::Get().RequestLibraryRefresh(false, false);
+		bLayoutChanged = false;
+		LastPollTime = Now;
+		LastStatRescanTime = Now;
+	}
+	else if (PollInterval > 0.0 && Now - LastPollTime >= PollInterval)
+	{
+		FVaultModule::Get().RequestLibraryRefresh(false, true);
+		LastPollTime = Now;
+	}
+
+	return true;
+}
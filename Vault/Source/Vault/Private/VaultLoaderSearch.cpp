@@ -0,0 +1,200 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultLoaderSearch.h"
+#include "VaultFuzzySearch.h"
+#include "VaultStringDictionary.h"
+
+#include "Async/Async.h"
+
+const int32 FVaultLoaderSearch::MaxBatchSize = 256;
+const double FVaultLoaderSearch::MaxBatchSeconds = 0.016;
+
+namespace VaultLoaderSearchUtils
+{
+	// Rows checked between looks at the clock and the cancel flag.
+	static const int32 RowsPerCheck = 64;
+}
+
+FVaultLoaderSearch::FVaultLoaderSearch(FParams InParams, FOnResults InOnResults)
+	: Params(MoveTemp(InParams))
+	, OnResults(MoveTemp(InOnResults))
+{
+}
+
+TSharedRef<FVaultLoaderSearch, ESPMode::ThreadSafe> FVaultLoaderSearch::Start(FParams Params, FOnResults OnResults)
+{
+	check(IsInGameThread());
+	check(Params.Library.IsValid());
+
+	TSharedRef<FVaultLoaderSearch, ESPMode::ThreadSafe> Search = MakeShareable(new FVaultLoaderSearch(MoveTemp(Params), MoveTemp(OnResults)));
+
+	Async(EAsyncExecution::ThreadPool, [Search]()
+	{
+		Search->Run();
+	});
+
+	return Search;
+}
+
+void FVaultLoaderSearch::Cancel()
+{
+	check(IsInGameThread());
+	bCancelled = true;
+	OnResults = nullptr;
+}
+
+bool FVaultLoaderSearch::IsCancelled() const
+{
+	return bCancelled;
+}
+
+void FVaultLoaderSearch::Run()
+{
+	using namespace VaultLoaderSearchUtils;
+
+	const FVaultLibrarySnapshot& Library = *Params.Library;
+
+	TArray<int32> Candidates;
+	bool bInDisplayOrder = false;
+	bool bAlreadyMatched = false;
+
+	if (Params.Mode == EMode::Fuzzy && FVaultFuzzySearch::Search(Library, Params.SearchText, Params.bNameOnly, Params.AllowedRows, FVaultFuzzySearch::DefaultMaxResults, Candidates, bCancelled))
+	{
+		// Ranked best match first, and every one of them a match.
+		bInDisplayOrder = true;
+		bAlreadyMatched = true;
+	}
+	else if (Params.Mode == EMode::Query)
+	{
+		Params.Query->GetCandidateRows(Library, Params.AllowedRows, Candidates, &bCancelled);
+	}
+	else if (Library.SearchIndex->FindCandidates(Params.SearchText, Params.bNameOnly, Candidates, &bCancelled))
+	{
+		// The index knows nothing about the tag and dev filters, drop what they filter out.
+		Candidates.RemoveAll([this](const int32 Row)
+		{
+			return !Params.AllowedRows.Contains(Row);
+		});
+	}
+	else if (Params.bNarrowPrevious)
+	{
+		Candidates = Params.PreviousRows;
+		bInDisplayOrder = true;
+	}
+	else
+	{
+		Params.AllowedRows.GetRows(Candidates);
+	}
+
+	if (IsCancelled())
+	{
+		return;
+	}
+
+	// Sorting the candidates up front lets every batch be appended to the list as is.
+	if (!bInDisplayOrder)
+	{
+		Library.Catalog->SortRows(Candidates, Params.SortingType, Params.bSortReversed, &bCancelled);
+		if (IsCancelled())
+		{
+			return;
+		}
+	}
+
+	// Match the search against the tag dictionary once, then every pack only needs to check ids.
+	const TArray<int32> MatchingTagIds = Params.Mode == EMode::Query || Params.bNameOnly ? TArray<int32>() : FVaultStringDictionary::Tags().FindIdsContaining(Params.SearchText);
+
+	TArray<int32> Batch;
+	double LastPostTime = FPlatformTime::Seconds();
+
+	for (int32 Index = 0; Index < Candidates.Num(); Index++)
+	{
+		if (Index % RowsPerCheck == 0)
+		{
+			if (IsCancelled())
+			{
+				return;
+			}
+
+			if (Batch.Num() > 0 && FPlatformTime::Seconds() - LastPostTime >= MaxBatchSeconds)
+			{
+				PostBatch(Batch, false);
+				LastPostTime = FPlatformTime::Seconds();
+			}
+		}
+
+		const int32 Row = Candidates[Index];
+		if (bAlreadyMatched || Matches(Row, MatchingTagIds))
+		{
+			Batch.Add(Row);
+
+			if (Batch.Num() >= MaxBatchSize)
+			{
+				PostBatch(Batch, false);
+				LastPostTime = FPlatformTime::Seconds();
+			}
+		}
+	}
+
+	PostBatch(Batch, true);
+}
+
+bool FVaultLoaderSearch::Matches(int32 Row, const TArray<int32>& MatchingTagIds) const
+{
+	const FVaultLibrarySnapshot& Library = *Params.Library;
+
+	if (Params.Mode == EMode::Query)
+	{
+		return Params.Query->Matches(Library, Row);
+	}
+
+	const FVaultMetadata& Meta = Library.Assets[Row];
+
+	if (Meta.PackName.ToString().Contains(Params.SearchText))
+	{
+		return true;
+	}
+
+	if (Params.bNameOnly)
+	{
+		return false;
+	}
+
+	if (Meta.Author.ToString().Contains(Params.SearchText) || Meta.Description.Contains(Params.SearchText))
+	{
+		return true;
+	}
+
+	for (const int32 TagId : MatchingTagIds)
+	{
+		if (Library.Catalog->HasTagId(Row, TagId))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FVaultLoaderSearch::PostBatch(TArray<int32>& Rows, bool bFinished)
+{
+	TSharedRef<FVaultLoaderSearch, ESPMode::ThreadSafe> Search = AsShared();
+
+	AsyncTask(ENamedThreads::GameThread, [Search, Rows = MoveTemp(Rows), bFinished]()
+	{
+		// Cancel runs on the game thread too, so nothing gets through once it has been called, queued batches included.
+		if (Search->IsCancelled() || !Search->OnResults)
+		{
+			return;
+		}
+
+		// Copied, the callback may well start the next search and cancel this one.
+		const FOnResults Callback = Search->OnResults;
+		if (bFinished)
+		{
+			Search->OnResults = nullptr;
+		}
+		Callback(Rows, bFinished);
+	});
+
+	Rows.Reset();
+}
@@ -1,6 +1,7 @@
 // Copyright Daniel Orchard 2020
 
 #include "VaultSettings.h"
+#include "Vault.h"
 #include "Misc/Paths.h"
 #include "Misc/DateTime.h"
 #include "JsonUtilities/Public/JsonUtilities.h"
@@ -8,6 +9,11 @@
 #include <Interfaces/IPluginManager.h>
 #include "Misc/AssertionMacros.h"
 #include "SVaultSetupWizard.h" // Our First time setup window
+#include "HAL/FileManager.h"
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
 
 // For simplicity in changing keys and looking them up, here's all the keys
 
@@ -29,13 +35,14 @@ static const FString GlobalSettingsFilePathFull = FVaultSettings::DefaultGlobals
 
 // Json Cloud, just to make it easy to update and refer back too:
 static const FString TagsKey = "Tags";
-static const FString TagArrayKey = "TagLibrary";
 static const FString GlobalSettingsPathKey = "GlobalSettingsPath";
 static const FString GlobalTagsPoolPathKey = "GlobalTagsPoolPath";
 static const FString VaultVersionKey = "Version";
 static const FString LibraryPath = "LibraryPath";
 static const FString DeveloperNameKey = "DeveloperName";
 static const FString ThumbnailCachePath = "ThumbnailCachePath";
+static const FString LibraryPollingIntervalKey = "LibraryPollingInterval";
+static const FString ConnectionProbeTimeoutKey = "ConnectionProbeTimeout";
 
 static const bool UseInternalSshConnection = false;
 
@@ -43,6 +50,14 @@ const FString FVaultSettings::LocalSettingsFilePathFull(FPaths::Combine(FPlatfor
 
 const FString FVaultSettings::DefaultThumbnailCacheFolder(FPaths::Combine(FPlatformProcess::UserDir(), DefaultVaultSettingsFolder, L"ThumbnailCache"));
 
+const FString FVaultSettings::LibraryCacheFolderFull(FPaths::Combine(FPlatformProcess::UserDir(), DefaultVaultSettingsFolder, L"LibraryCache"));
+
+const double FVaultSettings::DefaultLibraryPollingInterval = 30.0;
+
+const double FVaultSettings::DefaultConnectionProbeTimeout = 5.0;
+
+const double FVaultSettings::SnapshotTimestampCheckInterval = 2.0;
+
 // Random Extra Statics
 static const FString DefaultDeveloperName = FString(FPlatformProcess::UserName());
 
@@ -53,8 +68,8 @@ FVaultSettings& FVaultSettings::Get()
 	return VaultSettings;
 }
 
-// Init, set up files and folders etc. Called from Plugin startup
-void FVaultSettings::Initialize()
+// Set up files and folders. Called from the plugin's background startup phase, off the game thread.
+bool FVaultSettings::PrepareFiles()
 {
 	// Read Local Settings
 	FString LocalSettingsRaw;
@@ -73,6 +88,9 @@ void FVaultSettings::Initialize()
 		GenerateBaseLocalSettingsFile();
 	}
 
+	// Everything below finds the global files through the local settings.
+	RefreshSnapshot(false);
+
 	// Global Settings Setup and Test
 	FString GlobalSettingsRaw;
 	bool bLoadedGlobalSettings = FFileHelper::LoadFileToString(GlobalSettingsRaw, *GetGlobalSettingsFilePathFull());
@@ -103,65 +121,248 @@ void FVaultSettings::Initialize()
 		UpdateVaultFiles();
 	}
 
-	if (!bLoadedLocalSettings || !bLoadedGlobalSettings || !bLoadedTagPool)
+	// Have the first snapshot ready before anyone on the game thread asks for it.
+	RefreshSnapshot(false);
+
+	return bLoadedLocalSettings && bLoadedGlobalSettings && bLoadedTagPool;
+}
+
+TArray<FString> FVaultSettings::FindWatchableDirectories()
+{
+	const FString LocalDirectory = FPaths::GetPath(LocalSettingsFilePathFull);
+
+	TArray<FString> Directories;
+	Directories.Add(LocalDirectory);
+
+	// The global files can live anywhere. Whatever doesn't answer now is only checked by timestamp, see TickSnapshotRefresh.
+	const FVaultSettingsSnapshotRef Current = GetSnapshot();
+	for (const FString& Directory : { FPaths::GetPath(Current->GlobalSettingsFilePath), FPaths::GetPath(Current->GlobalTagsPoolFilePath) })
+	{
+		if (Directory.IsEmpty() || Directories.Contains(Directory))
+		{
+			continue;
+		}
+
+		if (IFileManager::Get().DirectoryExists(*Directory))
+		{
+			Directories.Add(Directory);
+		}
+		else
+		{
+			UE_LOG(LogVault, Display, TEXT("Settings folder %s can't be reached, not watching it for changes."), *Directory);
+		}
+	}
+
+	return Directories;
+}
+
+// Game thread half of the settings startup, once PrepareFiles and FindWatchableDirectories are done.
+void FVaultSettings::Initialize(bool bFilesExisted, const TArray<FString>& WatchDirectories)
+{
+	if (!bFilesExisted)
 	{
 		IsEditorInitialized = false;
 		FSlateRenderer* SlateRenderer = FSlateApplication::Get().GetRenderer();
 		LoadedDelegateHandle = SlateRenderer->OnSlateWindowRendered().AddRaw(this, &FVaultSettings::OnEditorLoaded);
 	}
 
-	CheckConnection();
-}
+	// Shares often don't send change notifications, so the timestamps are checked in the background as well.
+	SnapshotTickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FVaultSettings::TickSnapshotRefresh), SnapshotTimestampCheckInterval);
 
-// Get vault local
-TSharedPtr<FJsonObject> FVaultSettings::GetVaultLocalSettings()
-{
-	FString LocalSettingsRaw;
-	FFileHelper::LoadFileToString(LocalSettingsRaw, *LocalSettingsFilePathFull);
-	TSharedPtr<FJsonObject> JsonLocalSettings = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(LocalSettingsRaw);
-	FJsonSerializer::Deserialize(JsonReader, JsonLocalSettings);
-	return JsonLocalSettings;
+	// Pick up edits made by hand or by the settings window of another editor.
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get())
+	{
+		for (const FString& Directory : WatchDirectories)
+		{
+			FDelegateHandle Handle;
+			if (DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(Directory, IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FVaultSettings::OnSettingsDirectoryChanged), Handle))
+			{
+				WatchedDirectories.Emplace(Directory, Handle);
+			}
+		}
+	}
 }
 
-TSharedPtr<FJsonObject> FVaultSettings::GetVaultGlobalSettings()
+void FVaultSettings::Shutdown()
 {
-	FString SettingsTextRaw;
-	FFileHelper::LoadFileToString(SettingsTextRaw, *GetGlobalSettingsFilePathFull());
-	TSharedPtr<FJsonObject> JsonSettings = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(SettingsTextRaw);
-	FJsonSerializer::Deserialize(JsonReader, JsonSettings);
-	return JsonSettings;
+	if (SnapshotTickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(SnapshotTickerHandle);
+		SnapshotTickerHandle.Reset();
+	}
+
+	// The watcher module may already be gone during editor shutdown.
+	FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule ? DirectoryWatcherModule->Get() : nullptr;
+
+	for (TPair<FString, FDelegateHandle>& Watched : WatchedDirectories)
+	{
+		if (DirectoryWatcher)
+		{
+			DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(Watched.Key, Watched.Value);
+		}
+	}
+	WatchedDirectories.Empty();
 }
 
-// Public - Get Asset Library Root Accessor
-FString FVaultSettings::GetAssetLibraryRoot()
+void FVaultSettings::OnSettingsDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
 {
-	TSharedPtr<FJsonObject> SettingsObj = GetVaultGlobalSettings();
+	const FString TagPoolFilename = FPaths::GetCleanFilename(GetSnapshot()->GlobalTagsPoolFilePath);
 
-	if (SettingsObj.IsValid())
+	for (const FFileChangeData& Change : FileChanges)
 	{
-		FString OutString;
-		if (SettingsObj->TryGetStringField(LibraryPath, OutString))
+		// The pool, its log, or a sealed log.
+		if (!TagPoolFilename.IsEmpty() && FPaths::GetCleanFilename(Change.Filename).StartsWith(TagPoolFilename))
 		{
-			return OutString;
+			TagPool.Invalidate();
 		}
-		else
+	}
+
+	for (const FFileChangeData& Change : FileChanges)
+	{
+		// The global settings file can have any name, so any json file counts.
+		if (FPaths::GetExtension(Change.Filename) == TEXT("json"))
 		{
-			return FString();
+			InvalidateSnapshot();
+			return;
 		}
 	}
-	return FString();
 }
 
-FString FVaultSettings::GetThumbnailCacheRoot()
+FVaultSettingsSnapshotRef FVaultSettings::GetSnapshot()
+{
+	FReadScopeLock ReadLock(SnapshotLock);
+	return Snapshot;
+}
+
+void FVaultSettings::InvalidateSnapshot()
+{
+	bSnapshotDirty = true;
+	StartSnapshotRefresh();
+}
+
+void FVaultSettings::RefreshSnapshot(bool bForce)
+{
+	FScopeLock RefreshScope(&RefreshLock);
+
+	const FVaultSettingsSnapshotRef Current = GetSnapshot();
+
+	if (bSnapshotLoaded && !bForce
+		&& IFileManager::Get().GetTimeStamp(*LocalSettingsFilePathFull) == Current->LocalSettingsTimestamp
+		&& IFileManager::Get().GetTimeStamp(*Current->GlobalSettingsFilePath) == Current->GlobalSettingsTimestamp)
+	{
+		return;
+	}
+
+	// Read without holding the pointer lock, getters keep returning the old values meanwhile.
+	FVaultSettingsSnapshotRef NewSnapshot = LoadSnapshot();
+	bSnapshotLoaded = true;
+
+	FWriteScopeLock WriteLock(SnapshotLock);
+	Snapshot = NewSnapshot;
+}
+
+void FVaultSettings::StartSnapshotRefresh()
 {
-	TSharedPtr<FJsonObject> SettingsObj = GetVaultLocalSettings();
-	if (SettingsObj.IsValid())
+	// A hung share holds up one refresh, not a pile of them.
+	if (bSnapshotRefreshInFlight.AtomicSet(true))
 	{
-		return SettingsObj->GetStringField(ThumbnailCachePath);
+		return;
 	}
-	return FString();
+
+	Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		RefreshSnapshot(bSnapshotDirty.AtomicSet(false));
+		bSnapshotRefreshInFlight = false;
+	});
+}
+
+bool FVaultSettings::TickSnapshotRefresh(float DeltaTime)
+{
+	StartSnapshotRefresh();
+	return true;
+}
+
+FVaultSettingsSnapshotRef FVaultSettings::LoadSnapshot()
+{
+	TSharedRef<FVaultSettingsSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FVaultSettingsSnapshot, ESPMode::ThreadSafe>();
+
+	// Take the timestamps first. A write that lands while we read is then caught by the next check.
+	NewSnapshot->LocalSettingsTimestamp = IFileManager::Get().GetTimeStamp(*LocalSettingsFilePathFull);
+
+	TSharedPtr<FJsonObject> Local = ReadJsonObjectFromFile(LocalSettingsFilePathFull);
+	double PollingInterval = DefaultLibraryPollingInterval;
+	double ProbeTimeout = DefaultConnectionProbeTimeout;
+	if (Local.IsValid())
+	{
+		Local->TryGetStringField(GlobalSettingsPathKey, NewSnapshot->GlobalSettingsFilePath);
+		Local->TryGetStringField(GlobalTagsPoolPathKey, NewSnapshot->GlobalTagsPoolFilePath);
+		Local->TryGetStringField(ThumbnailCachePath, NewSnapshot->ThumbnailCacheRoot);
+		Local->TryGetStringField(DeveloperNameKey, NewSnapshot->DeveloperName);
+		Local->TryGetNumberField(LibraryPollingIntervalKey, PollingInterval);
+		Local->TryGetNumberField(ConnectionProbeTimeoutKey, ProbeTimeout);
+	}
+	NewSnapshot->LibraryPollingInterval = FMath::Max(PollingInterval, 0.0);
+	NewSnapshot->ConnectionProbeTimeout = FMath::Max(ProbeTimeout, 0.5);
+
+	if (NewSnapshot->GlobalSettingsFilePath.IsEmpty())
+	{
+		NewSnapshot->GlobalSettingsFilePath = DefaultGlobalsPath / GlobalSettingsFilename;
+	}
+
+	NewSnapshot->GlobalSettingsTimestamp = IFileManager::Get().GetTimeStamp(*NewSnapshot->GlobalSettingsFilePath);
+
+	TSharedPtr<FJsonObject> Global = ReadJsonObjectFromFile(NewSnapshot->GlobalSettingsFilePath);
+	if (Global.IsValid())
+	{
+		Global->TryGetStringField(LibraryPath, NewSnapshot->AssetLibraryRoot);
+	}
+
+	return NewSnapshot;
+}
+
+TSharedPtr<FJsonObject> FVaultSettings::ReadJsonObjectFromFile(const FString& FilepathFull)
+{
+	FString JsonRaw;
+	FFileHelper::LoadFileToString(JsonRaw, *FilepathFull);
+	TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject());
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonRaw);
+	FJsonSerializer::Deserialize(JsonReader, JsonObject);
+	return JsonObject;
+}
+
+// Get vault local
+// Always a fresh read, callers may modify and write it back. Prefer the cached getters below.
+TSharedPtr<FJsonObject> FVaultSettings::GetVaultLocalSettings()
+{
+	return ReadJsonObjectFromFile(LocalSettingsFilePathFull);
+}
+
+TSharedPtr<FJsonObject> FVaultSettings::GetVaultGlobalSettings()
+{
+	return ReadJsonObjectFromFile(GetGlobalSettingsFilePathFull());
+}
+
+// Public - Get Asset Library Root Accessor
+FString FVaultSettings::GetAssetLibraryRoot()
+{
+	return GetSnapshot()->AssetLibraryRoot;
+}
+
+FString FVaultSettings::GetThumbnailCacheRoot()
+{
+	return GetSnapshot()->ThumbnailCacheRoot;
+}
+
+double FVaultSettings::GetLibraryPollingInterval()
+{
+	return GetSnapshot()->LibraryPollingInterval;
+}
+
+double FVaultSettings::GetConnectionProbeTimeout()
+{
+	return GetSnapshot()->ConnectionProbeTimeout;
 }
 
 FString FVaultSettings::GetProjectVaultFolder()
@@ -172,32 +373,19 @@ FString FVaultSettings::GetProjectVaultFolder()
 
 bool FVaultSettings::CheckConnection()
 {
-	IsConnected = false;
-	if (GetVaultGlobalSettings().IsValid())
+	FString OutputDirectory = GetAssetLibraryRoot();
+	if (OutputDirectory.IsEmpty())
 	{
-		FString OutputDirectory = FVaultSettings::Get().GetAssetLibraryRoot();
-		if (!OutputDirectory.IsEmpty() && FPaths::DirectoryExists(OutputDirectory))
-		{
-			IsConnected = true;
-		}
-		else if (OutputDirectory.IsEmpty())
-		{
-			IsConnected = false;
-		}
-		else
-		{
-			IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
-			if (!platformFile.CreateDirectory(*OutputDirectory))
-			{
-				IsConnected = false;
-			}
-			else
-			{
-				IsConnected = true;
-			}
-		}
+		return false;
+	}
+
+	if (FPaths::DirectoryExists(OutputDirectory))
+	{
+		return true;
 	}
-	return IsConnected;
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	return platformFile.CreateDirectory(*OutputDirectory);
 }
 
 // Write any Json file out to a file.
@@ -207,7 +395,11 @@ bool FVaultSettings::WriteJsonObjectToFile(TSharedPtr<FJsonObject> JsonFile, FSt
 	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
 	FJsonSerializer::Serialize(JsonFile.ToSharedRef(), Writer);
 
-	return FFileHelper::SaveStringToFile(OutputString, *FilepathFull);
+	const bool bSaved = FFileHelper::SaveStringToFile(OutputString, *FilepathFull);
+
+	// Whoever wrote the file expects to read it back right away. The write already went to disk on this thread.
+	RefreshSnapshot(true);
+	return bSaved;
 }
 
 void FVaultSettings::GenerateBaseLocalSettingsFile()
@@ -220,6 +412,8 @@ void FVaultSettings::GenerateBaseLocalSettingsFile()
 	JsonLocalSettings->SetBoolField(TEXT("ClearPackageListOnSuccessfulPackage"), false);
 	JsonLocalSettings->SetStringField(DeveloperNameKey, DefaultDeveloperName);
 	JsonLocalSettings->SetStringField(ThumbnailCachePath, DefaultThumbnailCacheFolder);
+	JsonLocalSettings->SetNumberField(LibraryPollingIntervalKey, DefaultLibraryPollingInterval);
+	JsonLocalSettings->SetNumberField(ConnectionProbeTimeoutKey, DefaultConnectionProbeTimeout);
 
 	// We grab the System TEMP Env path here so we can have a safe directory to dump logs too.
 	FString TempPath = FPlatformMisc::GetEnvironmentVariable(TEXT("TEMP"));
@@ -242,34 +436,19 @@ void FVaultSettings::GenerateBaseGlobalSettingsFile()
 void FVaultSettings::GenerateBaseTagPoolFile()
 {
 	TSet<FString> PlaceholderTag = { "Environment", "Prop", "Character" };
-	SaveVaultTags(PlaceholderTag);
+	FVaultTagPool::CreatePool(GetGlobalTagsPoolFilePathFull(), PlaceholderTag);
+	TagPool.Invalidate();
 }
 
 FString FVaultSettings::GetGlobalSettingsFilePathFull()
 {
-	FString LocalSettingsRaw;
-	FFileHelper::LoadFileToString(LocalSettingsRaw, *LocalSettingsFilePathFull);
-	TSharedPtr<FJsonObject> JsonLocalSettings = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(LocalSettingsRaw);
-	FJsonSerializer::Deserialize(JsonReader, JsonLocalSettings);
-	FString SettingsPath = JsonLocalSettings->GetStringField(GlobalSettingsPathKey);
-
-	if (SettingsPath.IsEmpty())
-	{
-		return (DefaultGlobalsPath / GlobalSettingsFilename);
-	}
-	return SettingsPath;
+	return GetSnapshot()->GlobalSettingsFilePath;
 }
 
 FString FVaultSettings::GetGlobalTagsPoolFilePathFull()
 {
-	// We get the global tags path from the local settings, so lets load that
-	FString LocalSettingsRaw;
-	FFileHelper::LoadFileToString(LocalSettingsRaw, *LocalSettingsFilePathFull);
-	TSharedPtr<FJsonObject> JsonLocalSettings = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(LocalSettingsRaw);
-	FJsonSerializer::Deserialize(JsonReader, JsonLocalSettings);
-	return JsonLocalSettings->GetStringField(GlobalTagsPoolPathKey);
+	// We get the global tags path from the local settings
+	return GetSnapshot()->GlobalTagsPoolFilePath;
 }
 
 FString FVaultSettings::GetVaultPluginVersion()
@@ -316,73 +495,15 @@ void FVaultSettings::OnEditorLoaded(SWindow& SlateWindow, void* ViewportRHIPtr)
 
 bool FVaultSettings::SaveVaultTags(TSet<FString> NewTags)
 {
-	// A set of new tags to save, pulls previous tags into it so the new ones can amend in.
-	TSet<FString> TagsToSave;
-
-	ReadVaultTags(TagsToSave);
-
-	// Json Object to be written
-	TSharedPtr<FJsonObject> JsonTags = MakeShareable(new FJsonObject());
-
-	// Append our new tags to old. Since they are Sets, there wont be any duplicates
-	TagsToSave.Append(NewTags);
-
-	// Sort Alphabetically Lambda.
-	TagsToSave.Sort([](const FString& A, const FString& B)
-	{
-		return A > B;
-	});
-
-	// Convert FString into JsonValues
-	TArray<TSharedPtr<FJsonValue>> TagElements;
-	for (FString Tag : TagsToSave)
-	{
-		TagElements.Add(MakeShareable(new FJsonValueString(Tag)));
-	}
-
-	// Store tags into an array
-	JsonTags->SetArrayField(TagArrayKey, TagElements);
-
-	return WriteJsonObjectToFile(JsonTags, GetGlobalTagsPoolFilePathFull());
-
+	return TagPool.Add(GetGlobalTagsPoolFilePathFull(), NewTags);
 }
 
 bool FVaultSettings::ReadVaultTags(TSet<FString>& OutTags)
 {
-	OutTags.Empty();
-
-	// Holder to read the file into
-	FString JsonString;
-
-	// We need to find our path to the vault tags file
-	bool bLoadedFile = FFileHelper::LoadFileToString(JsonString, *GetGlobalTagsPoolFilePathFull());
-
-	if (bLoadedFile)
-	{
-		TSharedPtr<FJsonObject> JsonTagsObject = MakeShareable(new FJsonObject());
-		TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
-
-		if (FJsonSerializer::Deserialize(JsonReader, JsonTagsObject) && JsonTagsObject.IsValid())
-		{
-			TArray<TSharedPtr<FJsonValue>> TagsArray = JsonTagsObject->GetArrayField(TagArrayKey);
-
-			for (int32 index = 0; index < TagsArray.Num(); index++)
-			{
-				OutTags.Add(TagsArray[index]->AsString());
-			}
-			return true;
-		}
-	}
-	return false;
+	return TagPool.Get(GetGlobalTagsPoolFilePathFull(), OutTags);
 }
 
 FText FVaultSettings::GetDefaultDeveloperName()
 {
-	FString LocalSettingsRaw;
-	FFileHelper::LoadFileToString(LocalSettingsRaw, *LocalSettingsFilePathFull);
-	TSharedPtr<FJsonObject> JsonLocalSettings = MakeShareable(new FJsonObject());
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(LocalSettingsRaw);
-	FJsonSerializer::Deserialize(JsonReader, JsonLocalSettings);
-
-	return FText::FromString(JsonLocalSettings->GetStringField(DeveloperNameKey));
+	return FText::FromString(GetSnapshot()->DeveloperName);
 }
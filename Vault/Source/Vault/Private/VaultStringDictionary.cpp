@@ -0,0 +1,72 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultStringDictionary.h"
+
+FVaultStringDictionary& FVaultStringDictionary::Tags()
+{
+	static FVaultStringDictionary TagDictionary;
+	return TagDictionary;
+}
+
+FVaultStringDictionary& FVaultStringDictionary::Authors()
+{
+	static FVaultStringDictionary AuthorDictionary;
+	return AuthorDictionary;
+}
+
+int32 FVaultStringDictionary::FindOrAdd(const FString& String)
+{
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const int32* Id = IdsByString.Find(String))
+		{
+			return *Id;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Somebody else may have added it between the two locks.
+	if (const int32* Id = IdsByString.Find(String))
+	{
+		return *Id;
+	}
+
+	const int32 NewId = Strings.Add(String);
+	IdsByString.Add(String, NewId);
+	return NewId;
+}
+
+int32 FVaultStringDictionary::Find(const FString& String) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const int32* Id = IdsByString.Find(String);
+	return Id ? *Id : INDEX_NONE;
+}
+
+FString FVaultStringDictionary::GetString(int32 Id) const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Strings.IsValidIndex(Id) ? Strings[Id] : FString();
+}
+
+int32 FVaultStringDictionary::Num() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Strings.Num();
+}
+
+TArray<int32> FVaultStringDictionary::FindIdsContaining(const FString& Substring) const
+{
+	TArray<int32> MatchingIds;
+
+	FReadScopeLock ReadLock(Lock);
+	for (int32 Id = 0; Id < Strings.Num(); Id++)
+	{
+		if (Strings[Id].Contains(Substring))
+		{
+			MatchingIds.Add(Id);
+		}
+	}
+	return MatchingIds;
+}
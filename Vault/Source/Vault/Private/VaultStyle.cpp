@@ -8,6 +8,7 @@
 #include "Interfaces/IPluginManager.h"
 #include "GenericPlatform/GenericPlatformFile.h"
 #include "VaultSettings.h"
+#include "VaultLibraryLayout.h"
 
 #define LOCTEXT_NAMESPACE "FVaultStyle"
 
@@ -422,38 +423,49 @@ TSharedRef< FSlateStyleSet > FVaultStyle::Create()
 
 bool FVaultStyle::CacheThumbnailsLocally()
 {
-	// cache thumbnails in an AsyncTask to not stall the editor while caching them
+	// Work from the published library snapshot, so the background task never touches anything the game thread might change under it.
+	const FVaultLibrarySnapshotPtr Snapshot = FVaultModule::Get().GetLibrarySnapshot();
+	if (!Snapshot.IsValid())
+	{
+		return false;
+	}
 
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, []() {
-		TArray<FString> ThumbnailFilesRemote;
+	const FString ThumbnailCacheRoot = FVaultSettings::Get().GetThumbnailCacheRoot();
+
+	// cache thumbnails in an AsyncTask to not stall the editor while caching them
+	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [Snapshot, ThumbnailCacheRoot]() {
 		TArray<FString> ThumbnailFilesCached;
 		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
-		FString Root = FVaultSettings::Get().GetAssetLibraryRoot();
-
-		if (!PlatformFile.DirectoryExists(*FVaultSettings::Get().GetThumbnailCacheRoot()))
+		if (!PlatformFile.DirectoryExists(*ThumbnailCacheRoot))
 		{
-			PlatformFile.CreateDirectory(*FVaultSettings::Get().GetThumbnailCacheRoot());
+			PlatformFile.CreateDirectory(*ThumbnailCacheRoot);
 		}
 
-		PlatformFile.FindFiles(ThumbnailFilesRemote, *Root, L".png");
-		PlatformFile.FindFiles(ThumbnailFilesCached, *FVaultSettings::Get().GetThumbnailCacheRoot(), L".png");
+		PlatformFile.FindFiles(ThumbnailFilesCached, *ThumbnailCacheRoot, L".png");
+
+		FScopedSlowTask CacheThumbnailsTask(Snapshot->Assets.Num(), LOCTEXT("CacheThumbnailsText", "Caching package thumbnails locally."));
 
-		FScopedSlowTask CacheThumbnailsTask(ThumbnailFilesRemote.Num(), LOCTEXT("CacheThumbnailsText", "Caching package thumbnails locally."));
+		TSet<FString> RemoteFilenames;
+		RemoteFilenames.Reserve(Snapshot->Assets.Num());
 
-		for (FString ThumbnailFile : ThumbnailFilesRemote)
+		for (const FVaultMetadata& Meta : Snapshot->Assets)
 		{
-			FString Filename = FPaths::GetCleanFilename(ThumbnailFile);
-			if (ThumbnailFilesCached.Contains(FPaths::Combine(FVaultSettings::Get().GetThumbnailCacheRoot(), Filename)))
+			const FString Filename = Meta.FileId.ToString() + TEXT(".png");
+			const FString ThumbnailFile = FVaultLibraryLayout::GetPackFilePath(Snapshot->LibraryRoot, Meta.FileId, TEXT("png"));
+			const FString CachedFile = FPaths::Combine(ThumbnailCacheRoot, Filename);
+			RemoteFilenames.Add(Filename);
+
+			if (ThumbnailFilesCached.Contains(CachedFile))
 			{
-				if (PlatformFile.GetTimeStamp(*ThumbnailFile) > PlatformFile.GetTimeStamp(*FPaths::Combine(FVaultSettings::Get().GetThumbnailCacheRoot(), Filename)))
+				if (PlatformFile.GetTimeStamp(*ThumbnailFile) > PlatformFile.GetTimeStamp(*CachedFile))
 				{
-					PlatformFile.CopyFile(*FPaths::Combine(FVaultSettings::Get().GetThumbnailCacheRoot(), Filename), *ThumbnailFile);
+					PlatformFile.CopyFile(*CachedFile, *ThumbnailFile);
 				}
 			}
 			else
 			{
-				PlatformFile.CopyFile(*FPaths::Combine(FVaultSettings::Get().GetThumbnailCacheRoot(), Filename), *ThumbnailFile);
+				PlatformFile.CopyFile(*CachedFile, *ThumbnailFile);
 			}
 			CacheThumbnailsTask.EnterProgressFrame();
 		}
@@ -461,19 +473,37 @@ bool FVaultStyle::CacheThumbnailsLocally()
 		for (FString ThumbnailCacheFile : ThumbnailFilesCached) {
 
 			FString Filename = FPaths::GetCleanFilename(ThumbnailCacheFile);
-			if (!ThumbnailFilesRemote.Contains(FPaths::Combine(Root, Filename)))
+			if (!RemoteFilenames.Contains(Filename))
 			{
 				PlatformFile.DeleteFile(*ThumbnailCacheFile);
 			}
 		}
-
-
-		//return false;
 	});
 
 	return true;
 }
 
+void FVaultStyle::CacheThumbnailLocally(FName FileId)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	const FString Filename = FileId.ToString() + TEXT(".png");
+	const FString RemoteFile = FVaultLibraryLayout::GetPackFilePath(FVaultSettings::Get().GetAssetLibraryRoot(), FileId, TEXT("png"));
+	const FString CachedFile = FPaths::Combine(FVaultSettings::Get().GetThumbnailCacheRoot(), Filename);
+
+	if (!PlatformFile.FileExists(*RemoteFile))
+	{
+		PlatformFile.DeleteFile(*CachedFile);
+		return;
+	}
+
+	if (!PlatformFile.FileExists(*CachedFile) || PlatformFile.GetTimeStamp(*RemoteFile) > PlatformFile.GetTimeStamp(*CachedFile))
+	{
+		PlatformFile.CreateDirectoryTree(*FVaultSettings::Get().GetThumbnailCacheRoot());
+		PlatformFile.CopyFile(*CachedFile, *RemoteFile);
+	}
+}
+
 void FVaultStyle::ReloadTextures()
 {
 	if (FSlateApplication::IsInitialized())
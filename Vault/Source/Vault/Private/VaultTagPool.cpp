@@ -0,0 +1,340 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultTagPool.h"
+#include "Vault.h"
+#include "VaultSettings.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/FileManager.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+const int64 FVaultTagPool::MaxLogSize = 64 * 1024;
+
+const FTimespan FVaultTagPool::SealedLogRetention = FTimespan::FromMinutes(10.0);
+
+namespace VaultTagPoolUtils
+{
+	static const FString TagArrayKey = TEXT("TagLibrary");
+
+	// Tags are stored one per line, so they can't span lines.
+	static bool IsValidTag(const FString& Tag)
+	{
+		int32 Index;
+		return !Tag.IsEmpty() && !Tag.FindChar(TEXT('\n'), Index) && !Tag.FindChar(TEXT('\r'), Index);
+	}
+
+	static bool ReadPoolFile(const FString& PoolFilePath, TSet<FString>& OutTags)
+	{
+		FString JsonString;
+		if (!FFileHelper::LoadFileToString(JsonString, *PoolFilePath))
+		{
+			return false;
+		}
+
+		TSharedPtr<FJsonObject> JsonTagsObject = MakeShareable(new FJsonObject());
+		TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
+
+		if (!FJsonSerializer::Deserialize(JsonReader, JsonTagsObject) || !JsonTagsObject.IsValid())
+		{
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* TagsArray = nullptr;
+		if (JsonTagsObject->TryGetArrayField(TagArrayKey, TagsArray))
+		{
+			for (const TSharedPtr<FJsonValue>& TagValue : *TagsArray)
+			{
+				OutTags.Add(TagValue->AsString());
+			}
+		}
+		return true;
+	}
+
+	// Written next to the pool and swapped in, so readers never see half a pool.
+	static bool WritePoolFile(const FString& PoolFilePath, const TSet<FString>& Tags)
+	{
+		TArray<FString> SortedTags = Tags.Array();
+		SortedTags.Sort([](const FString& A, const FString& B)
+		{
+			return A > B;
+		});
+
+		TArray<TSharedPtr<FJsonValue>> TagElements;
+		for (const FString& Tag : SortedTags)
+		{
+			TagElements.Add(MakeShareable(new FJsonValueString(Tag)));
+		}
+
+		TSharedPtr<FJsonObject> JsonTags = MakeShareable(new FJsonObject());
+		JsonTags->SetArrayField(TagArrayKey, TagElements);
+
+		FString OutputString;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+		FJsonSerializer::Serialize(JsonTags.ToSharedRef(), Writer);
+
+		const FString TempPath = PoolFilePath + TEXT(".tmp") + FGuid::NewGuid().ToString();
+		if (!FFileHelper::SaveStringToFile(OutputString, *TempPath))
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to write tag pool: %s"), *TempPath);
+			return false;
+		}
+
+		if (!IFileManager::Get().Move(*PoolFilePath, *TempPath, true, true))
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to replace tag pool: %s"), *PoolFilePath);
+			IFileManager::Get().Delete(*TempPath, false, true, true);
+			return false;
+		}
+
+		return true;
+	}
+
+	// Read the tags of every complete line from Offset on. OutEndOffset is just past the last complete line.
+	static bool ReadLogFile(const FString& LogFilePath, int64 Offset, TSet<FString>& OutTags, int64& OutEndOffset)
+	{
+		OutEndOffset = Offset;
+
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*LogFilePath, FILEREAD_Silent | FILEREAD_AllowWrite));
+		if (!Reader.IsValid())
+		{
+			return false;
+		}
+
+		if (Reader->TotalSize() <= Offset)
+		{
+			return true;
+		}
+
+		TArray<ANSICHAR> Bytes;
+		Bytes.SetNumUninitialized(static_cast<int32>(Reader->TotalSize() - Offset));
+		Reader->Seek(Offset);
+		Reader->Serialize(Bytes.GetData(), Bytes.Num());
+		if (Reader->IsError())
+		{
+			return false;
+		}
+
+		// A last line without its newline is still being written, it is read next time.
+		int32 LineStart = 0;
+		for (int32 Position = 0; Position < Bytes.Num(); Position++)
+		{
+			if (Bytes[Position] != '\n')
+			{
+				continue;
+			}
+
+			if (Position > LineStart)
+			{
+				const FUTF8ToTCHAR Tag(Bytes.GetData() + LineStart, Position - LineStart);
+				OutTags.Add(FString(Tag.Length(), Tag.Get()));
+			}
+
+			LineStart = Position + 1;
+		}
+
+		OutEndOffset = Offset + LineStart;
+		return true;
+	}
+
+	// Sealed logs are named <log>.<seal time in ticks>-<guid>.
+	static void FindSealedLogs(const FString& PoolFilePath, TArray<FString>& OutSealedLogPaths)
+	{
+		const FString LogFilePath = FVaultTagPool::GetLogFilePath(PoolFilePath);
+		const FString Directory = FPaths::GetPath(LogFilePath);
+
+		TArray<FString> Filenames;
+		IFileManager::Get().FindFiles(Filenames, *(LogFilePath + TEXT(".*")), true, false);
+
+		for (const FString& Filename : Filenames)
+		{
+			OutSealedLogPaths.Add(Directory / Filename);
+		}
+	}
+
+	static FDateTime GetSealTime(const FString& SealedLogPath, const FString& LogFilePath)
+	{
+		const FString Suffix = SealedLogPath.RightChop(LogFilePath.Len() + 1);
+		return FDateTime(FCString::Atoi64(*Suffix.Left(20)));
+	}
+}
+
+FString FVaultTagPool::GetLogFilePath(const FString& PoolFilePath)
+{
+	return PoolFilePath + TEXT(".log");
+}
+
+bool FVaultTagPool::CreatePool(const FString& PoolFilePath, const TSet<FString>& Tags)
+{
+	return VaultTagPoolUtils::WritePoolFile(PoolFilePath, Tags);
+}
+
+bool FVaultTagPool::Compact(const FString& PoolFilePath)
+{
+	using namespace VaultTagPoolUtils;
+
+	const FString LogFilePath = GetLogFilePath(PoolFilePath);
+	const FDateTime Now = FDateTime::UtcNow();
+
+	// Appends from here on start a fresh log. Fails while someone has the log open on Windows, they get to it next time.
+	if (IFileManager::Get().FileExists(*LogFilePath))
+	{
+		const FString SealedLogPath = FString::Printf(TEXT("%s.%020lld-%s"), *LogFilePath, Now.GetTicks(), *FGuid::NewGuid().ToString());
+		if (!IFileManager::Get().Move(*SealedLogPath, *LogFilePath, false, false, false, true))
+		{
+			UE_LOG(LogVault, Display, TEXT("Tag pool log is in use, compacting it later: %s"), *LogFilePath);
+			return false;
+		}
+	}
+
+	UE_LOG(LogVault, Display, TEXT("Compacting tag pool %s."), *PoolFilePath);
+
+	TSet<FString> Tags;
+	ReadPoolFile(PoolFilePath, Tags);
+
+	// Logs sealed by anyone, not just us. Some may already be in the pool, reading them again costs nothing.
+	TArray<FString> SealedLogPaths;
+	FindSealedLogs(PoolFilePath, SealedLogPaths);
+
+	for (const FString& SealedLogPath : SealedLogPaths)
+	{
+		int64 EndOffset = 0;
+		ReadLogFile(SealedLogPath, 0, Tags, EndOffset);
+	}
+
+	if (!WritePoolFile(PoolFilePath, Tags))
+	{
+		return false;
+	}
+
+	// A compaction that read the pool before ours and writes after it would drop these tags again. Keeping the sealed
+	// logs around for a while means anyone that slow still reads them, and readers see their tags in the meantime.
+	for (const FString& SealedLogPath : SealedLogPaths)
+	{
+		if (Now - GetSealTime(SealedLogPath, LogFilePath) > SealedLogRetention)
+		{
+			IFileManager::Get().Delete(*SealedLogPath, false, true, true);
+		}
+	}
+
+	return true;
+}
+
+bool FVaultTagPool::Add(const FString& PoolFilePath, const TSet<FString>& NewTags)
+{
+	const FString LogFilePath = GetLogFilePath(PoolFilePath);
+
+	FString Lines;
+	{
+		FScopeLock Lock(&CacheLock);
+		Refresh(PoolFilePath);
+
+		for (const FString& Tag : NewTags)
+		{
+			if (VaultTagPoolUtils::IsValidTag(Tag) && !CachedTags.Contains(Tag))
+			{
+				Lines += Tag + TEXT("\n");
+			}
+		}
+
+		if (Lines.IsEmpty())
+		{
+			return true;
+		}
+
+		// One write for all of them, so readers see either none or all of a line.
+		TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*LogFilePath, FILEWRITE_Append | FILEWRITE_AllowRead));
+		if (!Writer.IsValid())
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to append to tag pool log: %s"), *LogFilePath);
+			return false;
+		}
+
+		FTCHARToUTF8 Utf8(*Lines);
+		Writer->Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+
+		if (!Writer->Close())
+		{
+			UE_LOG(LogVault, Warning, TEXT("Unable to append to tag pool log: %s"), *LogFilePath);
+			return false;
+		}
+
+		// Our own lines are read again with the rest of the log, the set takes care of that.
+		for (const FString& Tag : NewTags)
+		{
+			if (VaultTagPoolUtils::IsValidTag(Tag))
+			{
+				CachedTags.Add(Tag);
+			}
+		}
+	}
+
+	if (IFileManager::Get().FileSize(*LogFilePath) > MaxLogSize)
+	{
+		Compact(PoolFilePath);
+		Invalidate();
+	}
+
+	return true;
+}
+
+bool FVaultTagPool::Get(const FString& PoolFilePath, TSet<FString>& OutTags)
+{
+	FScopeLock Lock(&CacheLock);
+
+	const double Now = FPlatformTime::Seconds();
+	if (bDirty || PoolFilePath != CachedPoolFilePath || Now - LastCheckTime >= FVaultSettings::SnapshotTimestampCheckInterval)
+	{
+		Refresh(PoolFilePath);
+	}
+
+	OutTags = CachedTags;
+	return bPoolExists;
+}
+
+void FVaultTagPool::Invalidate()
+{
+	FScopeLock Lock(&CacheLock);
+	bDirty = true;
+}
+
+void FVaultTagPool::Refresh(const FString& PoolFilePath)
+{
+	using namespace VaultTagPoolUtils;
+
+	const FString LogFilePath = GetLogFilePath(PoolFilePath);
+
+	const FDateTime NewPoolTimestamp = IFileManager::Get().GetTimeStamp(*PoolFilePath);
+
+	// No log yet reads as an empty one. FileSize gives -1 for it, which would look like a shrunk log on every check.
+	const int64 LogSize = FMath::Max<int64>(IFileManager::Get().FileSize(*LogFilePath), 0);
+
+	LastCheckTime = FPlatformTime::Seconds();
+	bDirty = false;
+
+	// A new pool file or a log that shrank mean a compaction happened. Its sealed logs hold what isn't in the pool yet.
+	if (PoolFilePath != CachedPoolFilePath || NewPoolTimestamp != PoolTimestamp || LogSize < LogOffset)
+	{
+		CachedPoolFilePath = PoolFilePath;
+		PoolTimestamp = NewPoolTimestamp;
+		LogOffset = 0;
+		CachedTags.Empty();
+
+		bPoolExists = ReadPoolFile(PoolFilePath, CachedTags);
+
+		TArray<FString> SealedLogPaths;
+		FindSealedLogs(PoolFilePath, SealedLogPaths);
+
+		for (const FString& SealedLogPath : SealedLogPaths)
+		{
+			int64 EndOffset = 0;
+			ReadLogFile(SealedLogPath, 0, CachedTags, EndOffset);
+		}
+	}
+
+	if (LogSize > LogOffset)
+	{
+		ReadLogFile(LogFilePath, LogOffset, CachedTags, LogOffset);
+	}
+}
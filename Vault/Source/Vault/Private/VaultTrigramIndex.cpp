@@ -0,0 +1,261 @@
+// Copyright Daniel Orchard 2020
+
+#include "VaultTrigramIndex.h"
+
+const int32 FVaultTrigramIndex::MinQueryLength = 3;
+
+namespace VaultTrigramIndexUtils
+{
+	// 21 bits per character covers all of Unicode, three of them fit a uint64.
+	static uint64 MakeTrigram(TCHAR A, TCHAR B, TCHAR C)
+	{
+		const uint64 Mask = (1 << 21) - 1;
+		return ((uint64(FChar::ToLower(A)) & Mask) << 42) | ((uint64(FChar::ToLower(B)) & Mask) << 21) | (uint64(FChar::ToLower(C)) & Mask);
+	}
+
+	static uint64 MakeBigram(TCHAR A, TCHAR B)
+	{
+		const uint64 Mask = (1 << 21) - 1;
+		return ((uint64(FChar::ToLower(A)) & Mask) << 21) | (uint64(FChar::ToLower(B)) & Mask);
+	}
+
+	static void SortUnique(TArray<uint64>& Grams)
+	{
+		Grams.Sort();
+		int32 NumUnique = 0;
+		for (int32 Index = 0; Index < Grams.Num(); Index++)
+		{
+			if (NumUnique == 0 || Grams[NumUnique - 1] != Grams[Index])
+			{
+				Grams[NumUnique++] = Grams[Index];
+			}
+		}
+		Grams.SetNum(NumUnique, false);
+	}
+
+	// Keep the rows of Rows that are also in Other. Both ascending.
+	static void IntersectSorted(TArray<int32>& Rows, const TArray<int32>& Other)
+	{
+		int32 NumKept = 0;
+		int32 OtherIndex = 0;
+		for (int32 Index = 0; Index < Rows.Num() && OtherIndex < Other.Num(); Index++)
+		{
+			while (OtherIndex < Other.Num() && Other[OtherIndex] < Rows[Index])
+			{
+				OtherIndex++;
+			}
+			if (OtherIndex < Other.Num() && Other[OtherIndex] == Rows[Index])
+			{
+				Rows[NumKept++] = Rows[Index];
+			}
+		}
+		Rows.SetNum(NumKept, false);
+	}
+
+	// Rows on at least MinShared of the posting lists of QueryGrams, ascending. QueryGrams must be distinct.
+	// Only rows on some posting list are ever touched.
+	static void FindRowsSharing(const TArray<uint64>& QueryGrams, const TMap<uint64, TArray<int32>>& Postings, int32 MinShared, int32 NumRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled)
+	{
+		OutRows.Reset();
+
+		TArray<uint16> SharedCounts;
+		SharedCounts.SetNumZeroed(NumRows);
+
+		for (const uint64 Gram : QueryGrams)
+		{
+			if (bCancelled && *bCancelled)
+			{
+				return;
+			}
+
+			if (const TArray<int32>* Rows = Postings.Find(Gram))
+			{
+				for (const int32 Row : *Rows)
+				{
+					if (++SharedCounts[Row] == MinShared)
+					{
+						OutRows.Add(Row);
+					}
+				}
+			}
+		}
+
+		OutRows.Sort();
+	}
+}
+
+void FVaultTrigramIndex::GetTrigrams(const FString& Text, TArray<uint64>& OutTrigrams)
+{
+	for (int32 Index = 0; Index + 2 < Text.Len(); Index++)
+	{
+		OutTrigrams.Add(VaultTrigramIndexUtils::MakeTrigram(Text[Index], Text[Index + 1], Text[Index + 2]));
+	}
+}
+
+void FVaultTrigramIndex::GetBigrams(const FString& Text, TArray<uint64>& OutBigrams)
+{
+	for (int32 Index = 0; Index + 1 < Text.Len(); Index++)
+	{
+		OutBigrams.Add(VaultTrigramIndexUtils::MakeBigram(Text[Index], Text[Index + 1]));
+	}
+}
+
+void FVaultTrigramIndex::Build(const TArray<FVaultMetadata>& Assets, const TMap<FName, FVaultMetaFileStat>& Stats, const FVaultTrigramIndex* Previous)
+{
+	using namespace VaultTrigramIndexUtils;
+
+	NameRows.Reset();
+	TextRows.Reset();
+	NameBigramRows.Reset();
+	KeywordBigramRows.Reset();
+	GramsByFileId.Reset();
+	GramsByFileId.Reserve(Assets.Num());
+
+	for (int32 Row = 0; Row < Assets.Num(); Row++)
+	{
+		const FVaultMetadata& Meta = Assets[Row];
+		const FVaultMetaFileStat* Stat = Stats.Find(Meta.FileId);
+		const FPackGrams* Known = Previous ? Previous->GramsByFileId.Find(Meta.FileId) : nullptr;
+
+		FPackGrams& Pack = GramsByFileId.Add(Meta.FileId);
+
+		if (Known && Stat && Known->Stat == *Stat)
+		{
+			Pack = *Known;
+		}
+		else
+		{
+			if (Stat)
+			{
+				Pack.Stat = *Stat;
+			}
+
+			// N-grams never span two fields, a substring always lies within one of them.
+			const FString PackName = Meta.PackName.ToString();
+			GetTrigrams(PackName, Pack.Name);
+			SortUnique(Pack.Name);
+
+			Pack.Text = Pack.Name;
+			GetTrigrams(Meta.Author.ToString(), Pack.Text);
+			GetTrigrams(Meta.Description, Pack.Text);
+			for (const FString& Tag : Meta.Tags)
+			{
+				GetTrigrams(Tag, Pack.Text);
+			}
+			SortUnique(Pack.Text);
+
+			GetBigrams(PackName, Pack.NameBigrams);
+			SortUnique(Pack.NameBigrams);
+
+			Pack.KeywordBigrams = Pack.NameBigrams;
+			for (const FString& Tag : Meta.Tags)
+			{
+				GetBigrams(Tag, Pack.KeywordBigrams);
+			}
+			SortUnique(Pack.KeywordBigrams);
+		}
+
+		// Rows are visited in order, so every posting list comes out ascending.
+		for (const uint64 Trigram : Pack.Name)
+		{
+			NameRows.FindOrAdd(Trigram).Add(Row);
+		}
+		for (const uint64 Trigram : Pack.Text)
+		{
+			TextRows.FindOrAdd(Trigram).Add(Row);
+		}
+		for (const uint64 Bigram : Pack.NameBigrams)
+		{
+			NameBigramRows.FindOrAdd(Bigram).Add(Row);
+		}
+		for (const uint64 Bigram : Pack.KeywordBigrams)
+		{
+			KeywordBigramRows.FindOrAdd(Bigram).Add(Row);
+		}
+	}
+}
+
+bool FVaultTrigramIndex::FindCandidates(const FString& Query, bool bNameOnly, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled) const
+{
+	using namespace VaultTrigramIndexUtils;
+
+	OutRows.Reset();
+
+	if (Query.Len() < MinQueryLength)
+	{
+		return false;
+	}
+
+	TArray<uint64> QueryTrigrams;
+	GetTrigrams(Query, QueryTrigrams);
+	SortUnique(QueryTrigrams);
+
+	const TMap<uint64, TArray<int32>>& Postings = bNameOnly ? NameRows : TextRows;
+
+	// Start from the shortest list, the result can only get shorter.
+	TArray<const TArray<int32>*, TInlineAllocator<16>> Lists;
+	for (const uint64 Trigram : QueryTrigrams)
+	{
+		const TArray<int32>* Rows = Postings.Find(Trigram);
+		if (!Rows)
+		{
+			return true;
+		}
+		Lists.Add(Rows);
+	}
+
+	Lists.Sort([](const TArray<int32>& A, const TArray<int32>& B)
+	{
+		return A.Num() < B.Num();
+	});
+
+	OutRows = *Lists[0];
+	for (int32 ListIndex = 1; ListIndex < Lists.Num() && OutRows.Num() > 0; ListIndex++)
+	{
+		if (bCancelled && *bCancelled)
+		{
+			break;
+		}
+		IntersectSorted(OutRows, *Lists[ListIndex]);
+	}
+
+	return true;
+}
+
+int32 FVaultTrigramIndex::CountDistinctTrigrams(const FString& Query)
+{
+	TArray<uint64> QueryTrigrams;
+	GetTrigrams(Query, QueryTrigrams);
+	VaultTrigramIndexUtils::SortUnique(QueryTrigrams);
+	return QueryTrigrams.Num();
+}
+
+int32 FVaultTrigramIndex::CountDistinctBigrams(const FString& Query)
+{
+	TArray<uint64> QueryBigrams;
+	GetBigrams(Query, QueryBigrams);
+	VaultTrigramIndexUtils::SortUnique(QueryBigrams);
+	return QueryBigrams.Num();
+}
+
+void FVaultTrigramIndex::FindRowsSharingTrigrams(const FString& Query, bool bNameOnly, int32 MinShared, int32 NumRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled) const
+{
+	using namespace VaultTrigramIndexUtils;
+
+	TArray<uint64> QueryTrigrams;
+	GetTrigrams(Query, QueryTrigrams);
+	SortUnique(QueryTrigrams);
+
+	FindRowsSharing(QueryTrigrams, bNameOnly ? NameRows : TextRows, MinShared, NumRows, OutRows, bCancelled);
+}
+
+void FVaultTrigramIndex::FindRowsSharingBigrams(const FString& Query, bool bNameOnly, int32 MinShared, int32 NumRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled) const
+{
+	using namespace VaultTrigramIndexUtils;
+
+	TArray<uint64> QueryBigrams;
+	GetBigrams(Query, QueryBigrams);
+	SortUnique(QueryBigrams);
+
+	FindRowsSharing(QueryBigrams, bNameOnly ? NameBigramRows : KeywordBigramRows, MinShared, NumRows, OutRows, bCancelled);
+}
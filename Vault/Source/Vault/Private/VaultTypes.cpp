@@ -1,56 +1,68 @@
 #include "VaultTypes.h"
 #include "Vault.h"
+#include "VaultStringDictionary.h"
 #include "EditorAssetLibrary.h"
 #include "AssetRegistryModule.h"
 
-FSimpleDelegate& FVaultMetadata::OnRenameRequested()
+void FVaultMetadata::InternStrings()
 {
-	return RenameRequestedEvent;
-}
+	FVaultStringDictionary& TagDictionary = FVaultStringDictionary::Tags();
 
-FSimpleDelegate& FVaultMetadata::OnRenameCanceled()
-{
-	return RenameCanceledEvent;
+	TagIds.Reset(Tags.Num());
+	for (const FString& Tag : Tags)
+	{
+		TagIds.Add(TagDictionary.FindOrAdd(Tag));
+	}
+	TagIds.Sort();
+
+	AuthorId = FVaultStringDictionary::Authors().FindOrAdd(Author.ToString());
 }
 
 int32 FVaultMetadata::CheckVersion()
 {
 	InProjectVersion = 0;
-	FVaultMetadata LocalAsset;
-	for (FVaultMetadata iAsset : FVaultModule::Get().ImportedMetaFileCache)
+
+	const FVaultModule& VaultModule = FVaultModule::Get();
+
+	// Imports tagged in the asset registry know their version without looking at anything else.
+	FDateTime ImportedLastModified;
+	bool bImportedAssetsPresent = false;
+	if (VaultModule.GetImportTracker() && VaultModule.GetImportTracker()->FindImportedPack(FileId, ImportedLastModified, bImportedAssetsPresent))
 	{
-		if (iAsset.FileId == this->FileId)
+		if (ImportedLastModified < this->LastModified)
+		{
+			InProjectVersion = bImportedAssetsPresent ? -1 : -2;
+		}
+		else
 		{
-			LocalAsset = iAsset;
-			break;
+			InProjectVersion = bImportedAssetsPresent ? 1 : 2;
 		}
+		return InProjectVersion;
 	}
 
-	
-
-
+	// Packs imported before their assets were tagged fall back to the local .meta copy.
+	const FVaultMetadata* LocalAsset = VaultModule.FindImportedMetadata(FileId);
 
-	if (LocalAsset.IsMetaValid())
+	if (LocalAsset && LocalAsset->IsMetaValid())
 	{
-		FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-		FString ObjectPath = LocalAsset.ObjectsInPack.Array()[0];
-		ObjectPath.RemoveFromStart(TEXT("/Game/"));
-		ObjectPath = FPaths::ProjectContentDir() + ObjectPath + ".uasset";
+		// Whether the imported assets are still in the content folder is checked off the game thread on every full refresh.
+		const bool bBaseAssetExists = VaultModule.IsImportedPackPresent(FileId);
 
-		if (LocalAsset.LastModified < this->LastModified) {
+		if (LocalAsset->LastModified < this->LastModified) {
 			InProjectVersion = -1;
+			FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
 			if (!AssetRegistryModule.Get().IsLoadingAssets())
 			{
-				if (!FPaths::FileExists(ObjectPath))
+				if (!bBaseAssetExists)
 				{
 					InProjectVersion = -2;
 				}
 			}
 		}
-		else if (LocalAsset.LastModified >= this->LastModified)
+		else
 		{
 			InProjectVersion = 1;
-			if (!FPaths::FileExists(ObjectPath)) {
+			if (!bBaseAssetExists) {
 				InProjectVersion = 2;
 			}
 
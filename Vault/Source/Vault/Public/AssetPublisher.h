@@ -23,7 +23,8 @@ public:
 	//static FOnVaultPackagingCompleted& OnVaultPackagingCompleted() { return OnVaultPackagingCompletedDelegate; }
 	static FOnVaultPackagingCompleted OnVaultPackagingCompletedDelegate;
 
-	static FReply TryPackageAsset(FString PackageName, FAssetData ExportAsset, FVaultMetadata AssetPublishMetadata, UTexture2D* ThumbnailTexture);
+	// Publish under FileId. An empty FileId publishes a new pack, which claims its id once the share is known to be reachable.
+	static FReply TryPackageAsset(FString FileId, FAssetData ExportAsset, FVaultMetadata AssetPublishMetadata, UTexture2D* ThumbnailTexture);
 
 	static void GetAssetDependenciesRecursive(const FName AssetPath, TSet<FName>& AllDependencies, const FString& OriginalRoot);
 	/// <summary>
@@ -46,8 +47,16 @@ public:
 	static bool RenamePackage(FName NewPackName, FVaultMetadata Meta);
 
 	static void ConvertImageBufferUInt8ToFColor(TArray<uint8>& inputData, TArray<FColor>& outputData);
-	static FName CreateUniquePackageFilename(int length = 16);
+	/// <summary>
+	/// Make up a FileId for a new pack: a millisecond timestamp followed by random bits, as 32 hex digits.
+	/// The pack's .meta file is created empty to claim the id, so two users can never publish under the same one.
+	/// </summary>
+	static FName CreateUniquePackageFilename();
+	// Give up the claim on a FileId if publishing never wrote its .meta file.
+	static void ReleasePackageFilename(FName FileId);
 	static FVaultMetadata FindMetadataByPackName(FName PackName);
+	// Whether a pack in the library already uses this name. Cheap enough to call on every keystroke.
+	static bool IsPackNameInUse(FName PackName);
 	static FVaultCategory GetAssetCategory(FAssetData AssetData);
 
 private:
@@ -10,17 +10,36 @@
 class VAULT_API FMetadataOps
 {
 public:
-	static FVaultMetadata ReadMetadata(FString File);
+	// bHeaderOnly skips the heavy fields (ObjectsInPack), see LoadDetails.
+	static FVaultMetadata ReadMetadata(FString File, bool bHeaderOnly = false);
 
 	static bool WriteMetadata(FVaultMetadata& Metadata);
 
-	static bool DeleteMetadata(FVaultMetadata& Metadata);
+	static bool DeleteMetadata(const FVaultMetadata& Metadata);
 
 	static TArray<FVaultMetadata> FindAllMetadataInLibrary();
 
 	static TArray<FVaultMetadata> FindAllMetadataImportedInProject();
 
-	static TArray<FVaultMetadata> FindAllMetadataInFolder(FString PathToFolder);
+	// Reads every .meta file in the folder. The parallel path reads and parses the files on a bounded worker pool, the result order is the same either way.
+	static TArray<FVaultMetadata> FindAllMetadataInFolder(FString PathToFolder, bool bParallel = true);
+
+	// List all .meta files of the library, across all of its shards.
+	static TArray<FString> FindAllMetaFilesInLibrary(const FString& LibraryRoot);
+
+	// List all .meta files in a folder, sorted by path.
+	static TArray<FString> FindAllMetaFilesInFolder(const FString& PathToFolder);
+
+	static TArray<FVaultMetadata> ReadMetadataFiles(const TArray<FString>& MetaFilepaths, bool bParallel, bool bHeaderOnly = false);
+
+	// Fill in the heavy fields of a header only library record, from a small LRU cache or the pack's .meta file. Safe to call from any thread.
+	static bool LoadDetails(FVaultMetadata& Metadata);
+
+	// How many packs' details LoadDetails keeps around.
+	static const int32 DetailsCacheSize;
+
+	// Upper bound on concurrent .meta reads, keeps us from flooding the network share.
+	static const int32 MaxIngestionWorkers;
 
 	static TSet<FString> GetAllTags();
 
@@ -28,8 +47,13 @@ public:
 
 	static bool CopyMetadataToLocal(FVaultMetadata& Metadata);
 
-private:
+	// Fill Metadata straight from the json tokens, without building an FJsonObject. Unknown fields are skipped.
+	static bool ReadMetadataFromJson(const FString& Json, FVaultMetadata& OutMetadata, bool bHeaderOnly = false);
+
+	// Write Metadata as json, in the same layout the FJsonObject path produces.
+	static FString WriteMetadataToJson(const FVaultMetadata& Metadata);
 
+	// FJsonObject based versions of the above. Only kept around to check and benchmark the streaming path against.
 	static FVaultMetadata ParseMetaJsonToVaultMetadata(TSharedPtr<FJsonObject> MetaFile);
 
 	static TSharedPtr<FJsonObject> ParseMetadataToJson(FVaultMetadata Metadata);
@@ -5,8 +5,9 @@
 #include "CoreMinimal.h"
 #include "SlateFwd.h"
 #include "VaultTypes.h"
+#include "VaultLibraryItem.h"
 
-DECLARE_DELEGATE_RetVal_FourParams(bool, FOnVerifyRenameCommit, const TSharedPtr<FVaultMetadata>& /*AssetItem*/, const FText& /*NewName*/, const FSlateRect& /*MessageAnchor*/, FText& /*OutErrorMessage*/)
+DECLARE_DELEGATE_RetVal_FourParams(bool, FOnVerifyRenameCommit, const TSharedPtr<FVaultLibraryItem>& /*AssetItem*/, const FText& /*NewName*/, const FSlateRect& /*MessageAnchor*/, FText& /*OutErrorMessage*/)
 
 class VAULT_API SAssetTileItem : public SCompoundWidget
 {
@@ -15,7 +16,7 @@ public:
 	SLATE_BEGIN_ARGS(SAssetTileItem) {}
 
 	/** Item to use for populating */
-	SLATE_ARGUMENT(TSharedPtr<FVaultMetadata>, AssetItem)
+	SLATE_ARGUMENT(TSharedPtr<FVaultLibraryItem>, AssetItem)
 
 	SLATE_END_ARGS()
 
@@ -25,14 +26,14 @@ public:
 	void Construct(const FArguments& InArgs);
 
 	// Create the Tile Thumbnail, Returns Widget ready to use
-	TSharedRef<SWidget> CreateTileThumbnail(TSharedPtr<FVaultMetadata> Meta);
+	TSharedRef<SWidget> CreateTileThumbnail(const FVaultMetadata& Meta);
 
 	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
 
 private:
 
 	// Asset ref passed in on Construct by the Table Generator
-	TSharedPtr<FVaultMetadata> AssetItem;
+	TSharedPtr<FVaultLibraryItem> AssetItem;
 
 	// Holds the Thumbnail Brush (SlateBrush)
 	TSharedPtr<FSlateBrush> Brush;
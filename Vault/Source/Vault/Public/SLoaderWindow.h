@@ -7,6 +7,10 @@
 #include "Slate.h"
 #include "SlateExtras.h"
 #include "VaultTypes.h"
+#include "VaultLibrarySnapshot.h"
+#include "VaultLibraryItem.h"
+#include "VaultLibraryQuery.h"
+#include "VaultLoaderSearch.h"
 
 typedef TSharedPtr<FTagFilteringItem> FTagFilteringItemPtr;
 typedef TSharedPtr<FDeveloperFilteringItem> FDeveloperFilteringItemPtr;
@@ -25,6 +29,15 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 	// On Tick
 	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
 
+	// Switch the view over to the current library snapshot. Does nothing if the snapshot is already shown.
+	void CacheLibraryItems();
+
+	// Tile view item of a snapshot row, made the first time a tile needs it.
+	TSharedPtr<FVaultLibraryItem> GetLibraryItem(int32 Row);
+
+	// Rebuild FilteredAssetItems from FilteredRows.
+	void UpdateFilteredAssetItems();
+
 	// Populate the Base Asset Tree - No filtering Applied. Called on Construction
 	void PopulateBaseAssetList();
 
@@ -43,7 +56,7 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 	// ----  Tables  ---- //
 
 	// Create Individual Tile Widget. Bound to the GenerateTile Event
-	TSharedRef<ITableRow> MakeTileViewWidget(TSharedPtr<FVaultMetadata> AssetItem, const TSharedRef<STableViewBase>& OwnerTable);
+	TSharedRef<ITableRow> MakeTileViewWidget(TSharedPtr<FVaultLibraryItem> AssetItem, const TSharedRef<STableViewBase>& OwnerTable);
 
 	// Create the Category Filter Widget. Bound to the GenerateTile Event
 	TSharedRef<ITableRow> MakeCategoryFilterViewWidget(FCategoryFilteringItemPtr inCategory, const TSharedRef<STableViewBase>& OwnerTable);
@@ -55,9 +68,9 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 	TSharedRef<ITableRow> MakeDeveloperFilterViewWidget(FDeveloperFilteringItemPtr Entry, const TSharedRef<STableViewBase>& OwnerTable);
 	// ---- End Tables ----- //
 
-	void OnAssetTileSelectionChanged(TSharedPtr<FVaultMetadata> InItem, ESelectInfo::Type SelectInfo);
+	void OnAssetTileSelectionChanged(TSharedPtr<FVaultLibraryItem> InItem, ESelectInfo::Type SelectInfo);
 
-	void OnAssetTileDoubleClicked(TSharedPtr<FVaultMetadata> InItem);
+	void OnAssetTileDoubleClicked(TSharedPtr<FVaultLibraryItem> InItem);
 
 	TSharedPtr<SWidget> OnAssetTileContextMenuOpened();
 
@@ -106,8 +119,25 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 
 	// Widget Ref for Search Box Strict Search Check Box
 	TSharedPtr<SCheckBox> StrictSearchCheckBox;
+	TSharedPtr<SCheckBox> FuzzySearchCheckBox;
+
+	// Last query typed with keys, quotes or operators, kept so it is only parsed again when the text changes.
+	// Never changed once set, a search may still be reading it.
+	TSharedPtr<FVaultLibraryQuery, ESPMode::ThreadSafe> SearchQuery;
+
+	// Search running in the background. Its first batch of results replaces what the list shows.
+	TSharedPtr<FVaultLoaderSearch, ESPMode::ThreadSafe> ActiveSearch;
+	bool bActiveSearchShown = false;
+
+	// Last plain search that ran to the end, for a longer one to narrow down. Empty once the list changed since.
+	FString CompletedSearchText;
+	bool bCompletedSearchStrict = false;
 
 	void OnSearchBoxChanged(const FText& inSearchText);
+
+	void CancelSearch();
+
+	void OnSearchResults(const TArray<int32>& Rows, bool bFinished);
 	
 	void OnSearchBoxCommitted(const FText& InFilterText, ETextCommit::Type CommitType);
 
@@ -115,21 +145,22 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 
 	// ---- Metadata Zone ---- //
 
-	void ConstructMetadataWidget(TSharedPtr<FVaultMetadata> AssetMeta);
+	void ConstructMetadataWidget(TSharedPtr<FVaultLibraryItem> AssetItem);
 	TSharedPtr<SVerticalBox> MetadataWidget;
 	//TSharedPtr<SBox> MetaWrapper;
 	
 	// GLOBALS
 
-	void LoadAssetPackIntoProject(TSharedPtr<FVaultMetadata> InPack);
+	void LoadAssetPackIntoProject(TSharedPtr<FVaultLibraryItem> InItem);
 
-	void DeleteAssetPack(TSharedPtr<FVaultMetadata> InPack);
+	void DeleteAssetPack(TSharedPtr<FVaultLibraryItem> InItem);
 
 	TSet<FVaultCategory> ActiveCategoryFilters;
-	TSet<FString> ActiveTagFilters;
+	// Tag ids into FVaultStringDictionary::Tags()
+	TSet<int32> ActiveTagFilters;
 	TSet<FName> ActiveDevFilters;
 
-	// Force Refresh the File List. Does not call Redraw
+	// Start a background refresh of the File List. Views redraw once it is published.
 	void RefreshAvailableFiles();
 
 	void UpdateFilteredAssets();
@@ -139,9 +170,19 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 	void SortFilteredAssets(TEnumAsByte<SortingTypes> SortingType, bool Reverse = false);
 	void SortFilteredAssets();
 
-	TArray<TSharedPtr<FVaultMetadata>> FilteredAssetItems;
+	TArray<TSharedPtr<FVaultLibraryItem>> FilteredAssetItems;
+
+	// Library snapshot the view is built from. Filtering and sorting work on its catalog rows, FilteredAssetItems mirrors FilteredRows for the tile view.
+	FVaultLibrarySnapshotPtr DisplayedLibrary;
+	TArray<int32> FilteredRows;
+
+	// Rows that pass the category, tag and developer filters, before any search narrows them down.
+	FVaultRowSet FilterRows;
+
+	// Lazily created row items, indexed by snapshot row.
+	TArray<TSharedPtr<FVaultLibraryItem>> LibraryItems;
 
-	TSharedPtr<STileView<TSharedPtr<FVaultMetadata>>> TileView;
+	TSharedPtr<STileView<TSharedPtr<FVaultLibraryItem>>> TileView;
 
 	// Static Base Values
 	static const int32 THUMBNAIL_BASE_HEIGHT;
@@ -158,14 +199,13 @@ class VAULT_API SLoaderWindow : public SCompoundWidget
 
 	void RefreshLibrary();
 
+	// Rebuild filters and tiles from the current library snapshot without rescanning the library.
+	void RefreshLibraryViews();
+
 	// Bound to Static delegate in Asset Publisher, so we can update when user pushes a new asset or updates an existing one
 	void OnAssetUpdateHappened();
 
 private:
-	int32 LastSearchTextLength;
-
-	bool IsConnected;
-
 	bool bSortingReversed;
 	bool bHideBadHierarchyAssets;
 
@@ -173,7 +213,7 @@ public:
 
 	void ModifyActiveCategoryFilters(FVaultCategory CategoryModified, bool bFilterThis);
 
-	void ModifyActiveTagFilters(FString TagModified, bool bFilterThis);
+	void ModifyActiveTagFilters(int32 TagModified, bool bFilterThis);
 
 	void ModifyActiveDevFilters(FName DevModified, bool bFilterThis);
 };
@@ -8,12 +8,16 @@
 #include "VaultTypes.h"
 #include "ContentBrowserMenuExtension.h"
 #include "SVaultRootPanel.h"
+#include "VaultLibrarySnapshot.h"
+#include "VaultLibraryWatcher.h"
+#include "VaultImportTracker.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogVault, Log, All);
 
 DECLARE_DELEGATE_OneParam(FExportAssetDelegate, FAssetData&);
 DECLARE_DELEGATE_OneParam(FUpdateAssetDelegate, FVaultMetadata&);
 DECLARE_DELEGATE(FAssetWasUpdated);
+DECLARE_MULTICAST_DELEGATE(FOnLibrarySnapshotPublished);
 
 class FToolBarBuilder;
 class FMenuBuilder;
@@ -46,13 +50,42 @@ public:
 
 	UAssetPublisher* GetAssetPublisherInstance() { return AssetPublisherInstance; }
 
-	// Holder for all Meta files found during a file search. This is a cached version gathered on showing the ui, and can be updated with the RefreshAvailableFiles() function of the loader window.
-	TArray<FVaultMetadata> MetaFilesCache;
+	// All packs found in the library as of the last finished scan. May be null before the first scan.
+	// Game thread only, background work should be handed the pointer rather than call this.
+	FVaultLibrarySnapshotPtr GetLibrarySnapshot() const { return LibrarySnapshot; }
+
+	// Rescan the library on a background task. The current snapshot stays in place until the new one is published.
+	// By default every .meta file is statted. With bReplayJournal only the packs the journal lists as changed since the last
+	// refresh are re-read, see FVaultLibraryJournal. That misses anything the journal never got, so it is only for routine polls.
+	void RequestLibraryRefresh(bool bRecheckProjectVersions = true, bool bReplayJournal = false);
+
+	// Re-read only the given packs on a background task. Packs whose .meta file is gone are dropped.
+	// The thumbnails of ThumbnailFileIds are copied to the local cache by the same task.
+	void RequestPackRefresh(const TSet<FName>& FileIds, const TSet<FName>& ThumbnailFileIds = TSet<FName>());
+
+	bool IsLibraryRefreshing() const { return bLibraryRefreshInFlight; }
+
+	// Blocking rescan for callers that need a current library right away. Prefer RequestLibraryRefresh.
 	void UpdateMetaFilesCache();
 
+	// Broadcast on the game thread whenever a new library snapshot was published.
+	FOnLibrarySnapshotPublished OnLibrarySnapshotPublished;
+
 	// Holder for meta files that have been imported into the project before
 	TArray<FVaultMetadata> ImportedMetaFileCache;
 
+	// Imported record of a pack, null if it was never imported into this project. Game thread only.
+	const FVaultMetadata* FindImportedMetadata(FName FileId) const;
+
+	// Whether the assets of an imported pack are still in the project, as of the last full refresh. Packs that weren't checked yet count as present.
+	bool IsImportedPackPresent(FName FileId) const;
+
+	// Imported packs as the asset registry sees them. Null before startup and after shutdown.
+	FVaultImportTracker* GetImportTracker() const { return ImportTracker.Get(); }
+
+	// Recheck InProjectVersion of every pack against what is imported, and publish a new snapshot if any changed.
+	void RefreshProjectVersions();
+
 	void HandleRenameAsset();
 
 	TSharedPtr<class FUICommandList> PluginCommands;
@@ -65,6 +98,84 @@ private:
 
 	TSharedRef<SDockTab> CreateVaultMajorTab(const FSpawnTabArgs& TabSpawnArgs);
 
+	// Second startup phase, run once the editor has finished loading. Reads the settings on the thread pool,
+	// then starts the connection monitor, import tracker and a first library scan on the game thread.
+	void StartDeferredStartup();
+	void FinishDeferredStartup(bool bSettingsFilesExisted, const TArray<FString>& SettingsWatchDirectories);
+
+	FDelegateHandle EngineLoopInitCompleteHandle;
+
+	struct FLibraryRefreshRequest
+	{
+		bool bFullRescan = false;
+		bool bRecheckProjectVersions = false;
+		// Packs whose thumbnail changed on the share.
+		TSet<FName> ThumbnailFileIds;
+		// Full rescans only: catch up from the library journal if it still reaches back to our last refresh.
+		bool bReplayJournal = false;
+		TSet<FName> FileIds;
+
+		void Merge(const FLibraryRefreshRequest& Other);
+	};
+
+	struct FLibraryRefreshResult
+	{
+		bool bLibraryReachable = false;
+		TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Snapshot;
+		TArray<FVaultMetadata> ImportedMetadata;
+		// Whether each imported pack's first asset still exists in the project, keyed by FileId.
+		TMap<FName, bool> ImportedPackPresence;
+		// Journal generation the snapshot is current to, unset if the library has no journal.
+		TOptional<uint64> JournalGeneration;
+		// Modification time of every shard directory, set if the refresh listed the library.
+		TOptional<TMap<FString, FDateTime>> ShardTimes;
+	};
+
+	// Does the actual disk work of a refresh. Safe to call from any thread.
+	// Routine polls skip listing the shards whose directory time still matches KnownShardTimes.
+	static FLibraryRefreshResult RunLibraryRefresh(const FVaultLibrarySnapshotPtr& Previous, const FString& LibraryRoot, const FLibraryRefreshRequest& Request, const TOptional<uint64>& JournalGeneration,
+		const TMap<FString, FDateTime>& KnownShardTimes);
+
+	void QueueLibraryRefresh(const FLibraryRefreshRequest& Request);
+	void StartQueuedLibraryRefresh();
+
+	// Checks project versions and swaps the new snapshot in. Game thread only.
+	// Serial is the LibraryRefreshSerial the refresh started with. Results of refreshes overtaken by a later one are dropped.
+	void FinishLibraryRefresh(FLibraryRefreshResult& Result, const FLibraryRefreshRequest& Request, uint32 Serial);
+
+	// Publish the snapshot of the local library cache, unless a scan already published one. Game thread only.
+	void PublishCachedSnapshot(const TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe>& CachedSnapshot);
+
+	void WatchLibrary(const FString& LibraryRoot);
+
+	FVaultLibrarySnapshotPtr LibrarySnapshot;
+	uint32 LibrarySnapshotGeneration = 0;
+
+	// Index of every FileId in ImportedMetaFileCache.
+	TMap<FName, int32> ImportedMetaFileIndex;
+
+	TMap<FName, bool> ImportedPackPresence;
+
+	// Position in the library journal that LibrarySnapshot has caught up to.
+	TOptional<uint64> LibraryJournalGeneration;
+
+	// Modification time of every shard directory as of the last refresh that listed them, keyed by directory.
+	TMap<FString, FDateTime> LibraryShardTimes;
+
+	// Counts refreshes as they start, and the latest one whose result was taken. The blocking UpdateMetaFilesCache can
+	// finish while a background refresh that started earlier is still scanning, its older result must not replace the newer one.
+	uint32 LibraryRefreshSerial = 0;
+	uint32 FinishedLibraryRefreshSerial = 0;
+
+	bool bLibraryRefreshInFlight = false;
+	bool bLibraryRefreshQueued = false;
+	FLibraryRefreshRequest QueuedRefresh;
+
+	TUniquePtr<FVaultLibraryWatcher> LibraryWatcher;
+
+	TUniquePtr<FVaultImportTracker> ImportTracker;
+	FString WatchedLibraryRoot;
+
 
 	UAssetPublisher* AssetPublisherInstance;
 
@@ -0,0 +1,77 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EVaultConnectionState : uint8
+{
+	// No probe has finished yet.
+	Unknown,
+	Connected,
+	// Reachable, but the last probe took longer than half the timeout.
+	Degraded,
+	Offline
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnVaultConnectionStateChanged, EVaultConnectionState);
+
+/**
+ * Keeps track of whether the asset library root can be reached, without ever blocking the game thread on the share.
+ * Probes run on the thread pool. A probe that outlives the timeout marks the library offline right away, and no new probe
+ * starts until the hung one returns. While offline, probes back off exponentially so a dead VPN isn't hammered.
+ * UI code reads the cached state, which costs nothing.
+ */
+class VAULT_API FVaultConnectionMonitor
+{
+public:
+
+	static FVaultConnectionMonitor& Get();
+
+	void Start();
+
+	void Stop();
+
+	EVaultConnectionState GetState() const { return State; }
+
+	// Everything but a library known to be offline. Publishing and refreshing go ahead while the first probe is out.
+	bool IsReachable() const { return State != EVaultConnectionState::Offline; }
+
+	// Probe soon instead of waiting for the next scheduled probe. Never blocks.
+	// While offline this waits out the backoff, unless bIgnoreBackoff is set (the user asked for it).
+	void RequestProbe(bool bIgnoreBackoff = false);
+
+	// Broadcast on the game thread.
+	FOnVaultConnectionStateChanged OnStateChanged;
+
+	// Seconds between probes while the library is reachable.
+	static const double ProbeInterval;
+
+	// Upper bound on the backoff between probes while offline.
+	static const double MaxProbeBackoff;
+
+private:
+
+	bool Tick(float DeltaTime);
+
+	void StartProbe();
+
+	void FinishProbe(uint32 ProbeId, bool bReachable, double Duration);
+
+	void SetState(EVaultConnectionState NewState);
+
+	EVaultConnectionState State = EVaultConnectionState::Unknown;
+
+	FDelegateHandle TickerHandle;
+
+	bool bProbeInFlight = false;
+	bool bProbeTimedOut = false;
+	uint32 CurrentProbeId = 0;
+	double ProbeStartTime = 0.0;
+
+	// Timeout of the probe in flight, as the settings had it when it started.
+	double ProbeTimeout = 0.0;
+
+	double NextProbeTime = 0.0;
+	int32 ConsecutiveFailures = 0;
+};
@@ -0,0 +1,34 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VaultLibrarySnapshot.h"
+
+/**
+ * Typo tolerant search over a library snapshot.
+ * Candidates are the rows sharing enough trigrams with the query to be within the allowed number of edits, taken from the
+ * snapshot's trigram index. Queries too short for that search pack names and tags only, taking candidates from the bigram
+ * lists, or scoring every row when even those can't rule anything out. Each candidate is scored by the edit distance between
+ * the query and the closest substring of its fields, pack names weighing more than tags, and tags more than authors and descriptions.
+ */
+class VAULT_API FVaultFuzzySearch
+{
+public:
+
+	// Results past this many are dropped, nobody scrolls that far down a ranked list.
+	static const int32 DefaultMaxResults;
+
+	// Edits a query of this length may be off by.
+	static int32 GetMaxEdits(int32 QueryLength);
+
+	/**
+	 * Rows of AllowedRows matching Query, best match first. With bNameOnly only pack names are searched.
+	 * Returns false for queries too short for the trigram index, the caller should fall back to the plain search.
+	 * Stops early once bCancelled is set, OutRows is meaningless then.
+	 */
+	static bool Search(const FVaultLibrarySnapshot& Library, const FString& Query, bool bNameOnly, const FVaultRowSet& AllowedRows, int32 MaxResults, TArray<int32>& OutRows, const FThreadSafeBool& bCancelled);
+
+	// Fewest edits turning Query into any substring of Text, ignoring case. Stops counting past MaxEdits and returns MaxEdits + 1.
+	static int32 GetSubstringEditDistance(const FString& Query, const FString& Text, int32 MaxEdits);
+};
@@ -0,0 +1,68 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAssetData;
+class FVaultMetadata;
+
+/**
+ * Knows which Vault packs are imported into the project, straight from the asset registry.
+ * Imported assets carry the FileId and LastModified of their pack as package metadata, which the registry exposes as tags.
+ * Registry events keep the per-pack state current, so version checks are map lookups, and moving or deleting assets in the
+ * Content Browser reaches the loader's badges without a rescan.
+ */
+class VAULT_API FVaultImportTracker
+{
+public:
+
+	static const FName FileIdTag;
+	static const FName LastModifiedTag;
+
+	~FVaultImportTracker();
+
+	// Subscribe to the asset registry and pick up the tagged assets it already knows about.
+	void Start();
+
+	void Stop();
+
+	// Tag the assets of a freshly imported pack with its provenance and save them.
+	void TagImportedAssets(const FVaultMetadata& Pack, const TArray<FAssetData>& ImportedAssets);
+
+	// LastModified of the pack as imported, and whether any of its assets are still in the project.
+	// False for packs that were never imported, or whose assets predate tagging.
+	bool FindImportedPack(FName FileId, FDateTime& OutLastModified, bool& bOutAssetsPresent) const;
+
+	// How long the tracker waits for a burst of registry events to settle before badges are updated.
+	static const float SettleSeconds;
+
+private:
+
+	void OnAssetAdded(const FAssetData& AssetData);
+	void OnAssetRemoved(const FAssetData& AssetData);
+	void OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+
+	void AddAsset(FName ObjectPath, FName FileId, const FDateTime& LastModified);
+	void RemoveAsset(FName ObjectPath);
+
+	void MarkChanged();
+	bool FlushChanges(float DeltaTime);
+
+	// Packs stay around with no assets once the last one was deleted, so their badge can say so.
+	struct FImportedPack
+	{
+		int32 NumAssets = 0;
+		FDateTime LastModified;
+	};
+
+	TMap<FName, FImportedPack> ImportedPacks;
+
+	// Pack of every tagged asset, keyed by object path.
+	TMap<FName, FName> FileIdsByObjectPath;
+
+	FDelegateHandle AssetAddedHandle;
+	FDelegateHandle AssetRemovedHandle;
+	FDelegateHandle AssetRenamedHandle;
+	FDelegateHandle FlushHandle;
+};
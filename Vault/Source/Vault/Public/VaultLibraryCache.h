@@ -0,0 +1,32 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VaultLibrarySnapshot.h"
+
+/**
+ * Copy of the last published library snapshot on the local disk, one file per library root in FVaultSettings::LibraryCacheFolderFull.
+ * A new editor session shows it right away and reconciles it against the share in the background. The stored .meta file
+ * stats tell the reconciling scan which records are out of date, the same way they do for the library index.
+ */
+class VAULT_API FVaultLibraryCache
+{
+public:
+
+	// Bump whenever the header changes. The records themselves follow FVaultLibraryIndex::IndexVersion.
+	static const uint32 CacheVersion;
+
+	// Local cache file of one library root. Editors of different projects pointing at different libraries never share one.
+	static FString GetCacheFilePath(const FString& LibraryRoot);
+
+	// The cached snapshot, if there is one for this library root. Not published yet, and without catalog. Safe to call from any thread.
+	static TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Load(const FString& LibraryRoot);
+
+	// Write the snapshot on a background task. Saves requested while one is running collapse into one for the latest snapshot.
+	static void SaveAsync(const FVaultLibrarySnapshotPtr& Snapshot);
+
+private:
+
+	static bool Save(const FVaultLibrarySnapshot& Snapshot);
+};
@@ -0,0 +1,77 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VaultTypes.h"
+
+// Size and modification time of a .meta file, used to detect if the library index is out of date.
+struct FVaultMetaFileStat
+{
+	int64 Size = -1;
+	FDateTime ModificationTime;
+
+	bool operator==(const FVaultMetaFileStat& Other) const
+	{
+		return Size == Other.Size && ModificationTime == Other.ModificationTime;
+	}
+
+	bool operator!=(const FVaultMetaFileStat& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+/**
+ * Binary manifest (Library.vaultidx) stored next to the .meta files it describes: in the library root, or in every shard
+ * directory of a sharded library (see FVaultLibraryLayout).
+ * Holds the header fields of every FVaultMetadata record of the library (everything but ObjectsInPack), so loading the library costs a single file read instead of
+ * opening and parsing every .meta file. The .meta files stay the source of truth, the stored per-file stats tell which records need re-parsing.
+ */
+class VAULT_API FVaultLibraryIndex
+{
+public:
+
+	static const FString IndexFilename;
+
+	// Bump whenever the binary layout changes. Older indices are treated as missing and get rebuilt.
+	static const uint32 IndexVersion;
+
+	// Index file of one directory of packs.
+	static FString GetIndexFilePath(const FString& Directory);
+
+	// Stat every .meta file in the library, one directory listing per shard, keyed by FileId.
+	// Empty .meta files only claim a FileId and are left out. Claims abandoned long ago are deleted.
+	// OutDirectoryTimes receives the modification time of every shard directory. Shards whose time matches KnownDirectoryTimes
+	// are not listed, their stats are copied from KnownStats. Rewriting a .meta file in place doesn't touch its directory, so
+	// only skip shards when something else catches those.
+	static void GatherMetaFileStats(const FString& LibraryRoot, TMap<FName, FVaultMetaFileStat>& OutStats, TMap<FString, FDateTime>* OutDirectoryTimes = nullptr,
+		const TMap<FString, FDateTime>* KnownDirectoryTimes = nullptr, const TMap<FName, FVaultMetaFileStat>* KnownStats = nullptr);
+
+	// Read the indices of every shard that has one. Returns false if any of them was missing or unreadable.
+	static bool ReadIndex(const FString& LibraryRoot, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats);
+
+	// Write the index of every shard, or only of the given shard directories. Records outside of those are ignored.
+	static bool WriteIndex(const FString& LibraryRoot, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats, const TSet<FString>* OnlyDirectories = nullptr);
+
+	// Update a single record in its shard's index after its .meta file has been written.
+	static bool AddOrUpdateEntry(const FVaultMetadata& Metadata);
+
+	// Drop a single record from its shard's index after its .meta file has been deleted.
+	static bool RemoveEntry(FName FileId);
+
+	// Binary form of the records and their stats, shared with the local library cache.
+	static void SaveIndex(FArchive& Ar, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats);
+
+	static bool LoadIndex(FArchive& Ar, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats);
+
+private:
+
+	static void GatherMetaFileStatsInDirectory(const FString& Directory, TMap<FName, FVaultMetaFileStat>& OutStats);
+
+	// Read the index of one directory. Memory-maps the file when the platform supports it.
+	static bool ReadIndexFile(const FString& Directory, TArray<FVaultMetadata>& OutMetadata, TMap<FName, FVaultMetaFileStat>& OutStats);
+
+	static bool WriteIndexFile(const FString& Directory, const TArray<FVaultMetadata>& Metadata, const TMap<FName, FVaultMetaFileStat>& Stats);
+
+};
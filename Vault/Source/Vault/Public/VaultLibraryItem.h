@@ -0,0 +1,40 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VaultTypes.h"
+#include "VaultLibrarySnapshot.h"
+
+/**
+ * One pack as shown in the loader's tile view. Points into the library snapshot rather than copying the record, so building
+ * the view costs a pointer per row. Records are header only, take a copy and call FMetadataOps::LoadDetails for the object list.
+ */
+class VAULT_API FVaultLibraryItem
+{
+public:
+
+	FVaultLibraryItem(FVaultLibrarySnapshotPtr InLibrary, int32 InRow)
+		: Library(MoveTemp(InLibrary))
+		, Row(InRow)
+	{
+	}
+
+	const FVaultMetadata& GetMetadata() const { return Library->Assets[Row]; }
+
+	/** Get the event fired whenever a rename is requested */
+	FSimpleDelegate& OnRenameRequested() { return RenameRequestedEvent; }
+
+	/** Get the event fired whenever a rename is canceled */
+	FSimpleDelegate& OnRenameCanceled() { return RenameCanceledEvent; }
+
+private:
+
+	// Keeps the snapshot alive for as long as a tile shows the row.
+	FVaultLibrarySnapshotPtr Library;
+	int32 Row;
+
+	FSimpleDelegate RenameRequestedEvent;
+
+	FSimpleDelegate RenameCanceledEvent;
+};
@@ -0,0 +1,58 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EVaultJournalOp : uint8
+{
+	Publish,
+	Update,
+	Rename,
+	Delete
+};
+
+/**
+ * Append-only log of pack changes (Library.journal) in the asset library root.
+ * Every publish, metadata update, rename and delete appends one line, so editors can apply what others changed since
+ * their last refresh by reading the tail of the journal instead of statting the whole library.
+ *
+ * Generations are byte positions in the journal, offset by the base generation stored in the header. Compacting the journal
+ * moves the base past everything written so far, so generations only ever grow and a reader that fell behind a compaction
+ * can tell it has to rescan.
+ */
+class VAULT_API FVaultLibraryJournal
+{
+public:
+
+	static const FString JournalFilename;
+
+	// The journal is compacted once it grows past this many bytes.
+	static const int64 MaxJournalSize;
+
+	enum class EReadResult : uint8
+	{
+		// Everything since the given generation was read.
+		Ok,
+		// The journal was compacted past the given generation, the caller has to rescan.
+		Compacted,
+		// The journal could not be read.
+		Unavailable
+	};
+
+	static FString GetJournalFilePath(const FString& LibraryRoot);
+
+	// Record a change to a pack. Call after its files were written or deleted.
+	static bool Append(const FString& LibraryRoot, EVaultJournalOp Op, FName FileId);
+
+	// Generation after the last complete record, 0 for a library without a journal.
+	static uint64 GetEndGeneration(const FString& LibraryRoot);
+
+	// Drop every record and move the base generation past them. Every reader has to rescan afterwards.
+	static bool Compact(const FString& LibraryRoot);
+
+	// Collect the FileIds of every record after Generation. OutEndGeneration is where the next read should start.
+	static EReadResult ReadSince(const FString& LibraryRoot, uint64 Generation, TSet<FName>& OutFileIds, uint64& OutEndGeneration);
+
+	static const TCHAR* OpToString(EVaultJournalOp Op);
+};
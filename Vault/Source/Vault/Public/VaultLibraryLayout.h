@@ -0,0 +1,46 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Where the files of a pack live in the asset library.
+ * Flat libraries keep every .upack, .meta and .png file in the library root. Sharded libraries bucket them into
+ * subdirectories named after a two digit hex hash of the FileId, each with its own library index, so large libraries
+ * never list, parse or rewrite more than the shards that changed.
+ * Always build pack paths through here, never by appending the FileId to the library root.
+ */
+class VAULT_API FVaultLibraryLayout
+{
+public:
+
+	// Written to the library root once it was migrated to the sharded layout.
+	static const FString ShardedMarkerFilename;
+
+	static const int32 NumShards;
+
+	// Whether the library uses the sharded layout. Cached per library root, see DetectLayout.
+	static bool IsSharded(const FString& LibraryRoot);
+
+	// Check the library root for the marker file again and update the cached layout. Returns IsSharded.
+	static bool DetectLayout(const FString& LibraryRoot);
+
+	// Shard a FileId belongs to, independent of the layout the library uses.
+	static FString GetShardName(FName FileId);
+
+	// Directory holding the files of a pack: the library root, or the pack's shard directory.
+	static FString GetPackDirectory(const FString& LibraryRoot, FName FileId);
+
+	// Full path of one of a pack's files, Extension without the dot.
+	static FString GetPackFilePath(const FString& LibraryRoot, FName FileId, const TCHAR* Extension);
+
+	// Every directory that holds packs: the library root, or each shard directory that exists.
+	static TArray<FString> GetPackDirectories(const FString& LibraryRoot);
+
+	// Create an empty file, failing if it already exists. Unlike checking for the file first, this is atomic, also on SMB shares.
+	static bool CreateFileExclusive(const FString& Path);
+
+	// Move the packs of a flat library into shard directories and write the shard indices. Does nothing on a sharded library.
+	static bool MigrateToSharded(const FString& LibraryRoot);
+};
@@ -0,0 +1,77 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/TextFilterExpressionEvaluator.h"
+#include "HAL/ThreadSafeBool.h"
+#include "VaultLibrarySnapshot.h"
+
+/**
+ * Query typed into the loader's search box, e.g. tag:rock author:anna category:3D modified>2026-01-01 -tag:wip "exact phrase".
+ * Keys are name, tag, author, category, description, created and modified. Terms are ANDed unless joined with OR.
+ *
+ * FTextFilterExpressionEvaluator parses the text and has the final say on every row. Before it runs, the terms every match
+ * has to satisfy are turned into a plan over the snapshot's indices: tag, author and category terms pick catalog bitsets,
+ * plain words and phrases use the trigram index, and date terms compare the catalog columns. The smallest sets are
+ * applied first, so the evaluator only sees rows that are likely to match.
+ */
+class VAULT_API FVaultLibraryQuery
+{
+public:
+
+	FVaultLibraryQuery();
+
+	// Whether the text uses anything beyond plain words. Plain words are left to the regular search.
+	static bool IsStructured(const FString& QueryText);
+
+	// Parse the query and build its plan. False if the evaluator couldn't make sense of it, see GetErrorText.
+	// With bNameOnly plain words only match pack names, like the strict search.
+	bool SetQuery(const FString& QueryText, bool bNameOnly);
+
+	// Whether SetQuery was last called with these arguments.
+	bool IsSameQuery(const FString& InQueryText, bool bInNameOnly) const;
+
+	FText GetErrorText() const;
+
+	/**
+	 * Rows of AllowedRows the plan can't rule out, ascending. Only those can match, Matches decides.
+	 * Neither modifies the query, so once set it can be run from any thread. GetCandidateRows stops early once bCancelled is set.
+	 */
+	void GetCandidateRows(const FVaultLibrarySnapshot& Library, const FVaultRowSet& AllowedRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled = nullptr) const;
+	bool Matches(const FVaultLibrarySnapshot& Library, int32 Row) const;
+
+private:
+
+	enum class EStepKind : uint8
+	{
+		Tag,
+		Author,
+		Category,
+		Text,
+		Created,
+		Modified
+	};
+
+	// One term every match has to satisfy, answered from an index.
+	struct FPlanStep
+	{
+		EStepKind Kind;
+		ETextFilterComparisonOperation Operation;
+		FString Value;
+		bool bNegated = false;
+	};
+
+	// Add the step for one top-level term, if an index can answer it.
+	void AddPlanStep(FString Term, bool bNegated);
+
+	// Rows the step can't rule out. False if the step has no index to answer it.
+	bool GetStepRows(const FPlanStep& Step, const FVaultLibrarySnapshot& Library, FVaultRowSet& OutRows, const FThreadSafeBool* bCancelled) const;
+
+	TSharedRef<FTextFilterExpressionEvaluator> Evaluator;
+
+	TArray<FPlanStep> Plan;
+
+	FString QueryText;
+	bool bNameOnly = false;
+};
@@ -0,0 +1,157 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "VaultTypes.h"
+#include "VaultLibraryIndex.h"
+#include "VaultTrigramIndex.h"
+
+/**
+ * Set of catalog rows, one bit per row and 64 rows to a word. Filters combine these a word at a time.
+ * Sets that are combined must have been initialized to the same number of rows.
+ */
+struct VAULT_API FVaultRowSet
+{
+	TArray<uint64> Words;
+
+	void Init(int32 NumRows, bool bAllRows);
+
+	void Add(int32 Row)
+	{
+		Words[Row >> 6] |= uint64(1) << (Row & 63);
+	}
+
+	bool Contains(int32 Row) const
+	{
+		return (Words[Row >> 6] >> (Row & 63)) & 1;
+	}
+
+	void Intersect(const FVaultRowSet& Other);
+	void Union(const FVaultRowSet& Other);
+	void Subtract(const FVaultRowSet& Other);
+
+	// Number of rows in the set.
+	int32 Count() const;
+
+	// Append the rows in the set to OutRows, in ascending order.
+	void GetRows(TArray<int32>& OutRows) const;
+
+	int32 NumRows = 0;
+};
+
+/**
+ * Rows sharing one tag or author. Most tags are on a handful of packs, a bitset each would cost a bit per pack of the library
+ * for every distinct tag. Rare values keep a sorted row list, only common ones a bitset, whichever is smaller.
+ */
+struct VAULT_API FVaultRowGroup
+{
+	// Ascending, unless the group is dense.
+	TArray<int32> Rows;
+
+	// Only initialized for dense groups.
+	FVaultRowSet Set;
+
+	bool IsDense() const { return Set.NumRows > 0; }
+
+	// Add the group's rows to OutRows, which must be initialized to the catalog's number of rows.
+	void AddTo(FVaultRowSet& OutRows) const;
+};
+
+/**
+ * Column store of the fields the loader filters and sorts by, one entry per row of FVaultLibrarySnapshot::Assets.
+ * Filter and sort passes walk these small contiguous arrays instead of the full records.
+ */
+struct VAULT_API FVaultLibraryCatalog
+{
+	TArray<FName> PackNames;
+	TArray<uint8> Categories;
+	TArray<int32> AuthorIds;
+	TArray<int64> CreationTicks;
+	TArray<int64> ModifiedTicks;
+	TArray<int8> HierarchyBadness;
+
+	// Tag ids of a row are TagIds[TagIdOffsets[Row]] up to TagIds[TagIdOffsets[Row + 1]], sorted.
+	TArray<int32> TagIdOffsets;
+	TArray<int32> TagIds;
+
+	// Inverted indices for the loader's filters: the rows of every category, tag id and author id, and the rows with bad hierarchy.
+	TArray<FVaultRowSet> RowsByCategory;
+	TMap<int32, FVaultRowGroup> RowsByTagId;
+	TMap<int32, FVaultRowGroup> RowsByAuthorId;
+	FVaultRowSet RowsWithBadHierarchy;
+
+	// Row of every pack by FileId and by PackName.
+	TMap<FName, int32> RowByFileId;
+	TMap<FName, int32> RowByPackName;
+
+	// Every row ordered by pack name, by CreationTicks and by ModifiedTicks, for sorting and date range queries.
+	TArray<int32> RowsByName;
+	TArray<int32> RowsByCreationTicks;
+	TArray<int32> RowsByModifiedTicks;
+
+	int32 Num() const { return PackNames.Num(); }
+
+	TArrayView<const int32> GetTagIds(int32 Row) const
+	{
+		return TArrayView<const int32>(TagIds.GetData() + TagIdOffsets[Row], TagIdOffsets[Row + 1] - TagIdOffsets[Row]);
+	}
+
+	bool HasTagId(int32 Row, int32 TagId) const
+	{
+		return Algo::BinarySearch(GetTagIds(Row), TagId) != INDEX_NONE;
+	}
+
+	// Fill the columns from the records. Expects InternStrings to have run on them.
+	// Nothing here depends on what is imported into the project, so snapshots that only differ in InProjectVersion share one catalog.
+	void Build(const TArray<FVaultMetadata>& Assets);
+
+	// Order rows the way the loader lists them. Stops early once bCancelled is set, leaving Rows incomplete.
+	void SortRows(TArray<int32>& Rows, SortingTypes SortingType, bool bReverse, const FThreadSafeBool* bCancelled = nullptr) const;
+};
+
+/**
+ * The asset library as of one scan.
+ * Snapshots are built off the game thread and published by FVaultModule. Once published they are never modified,
+ * so any thread holding a pointer to one can read it without locking.
+ */
+struct VAULT_API FVaultLibrarySnapshot
+{
+	FString LibraryRoot;
+
+	TArray<FVaultMetadata> Assets;
+
+	// Size and modification time of every .meta file the assets were read from, keyed by FileId.
+	TMap<FName, FVaultMetaFileStat> MetaFileStats;
+
+	// Increases with every published snapshot, so views can tell if they are showing an old one.
+	uint32 Generation = 0;
+
+	// Columns and row maps for filtering, sorting and lookups. Built off the game thread, before the snapshot is published.
+	// Shared with copies of the snapshot, which may only differ in InProjectVersion.
+	TSharedPtr<const FVaultLibraryCatalog, ESPMode::ThreadSafe> Catalog;
+
+	// Null if no pack has this FileId or PackName. PackNames compare case-insensitive.
+	const FVaultMetadata* FindByFileId(FName FileId) const;
+	const FVaultMetadata* FindByPackName(FName PackName) const;
+
+	// Trigram posting lists for the loader's search box. Built and shared like the catalog.
+	TSharedPtr<const FVaultTrigramIndex, ESPMode::ThreadSafe> SearchIndex;
+
+	// Build the catalog and the search index from Assets. Called once, on the thread that built the snapshot.
+	// Previous is the snapshot this one replaces, the search index reuses what it can from it.
+	void BuildIndices(const FVaultLibrarySnapshot* Previous = nullptr);
+
+	/**
+	 * Build the snapshot that follows Previous. Only .meta files that were added or changed since Previous are parsed.
+	 * A full rescan stats the whole library, passing OnlyFileIds restricts the work to those packs.
+	 * A full rescan also reports the modification time of every shard directory in OutDirectoryTimes. Shards that still match
+	 * KnownDirectoryTimes are not listed again, see FVaultLibraryIndex::GatherMetaFileStats.
+	 * Returns null if nothing changed. Safe to call from any thread.
+	 */
+	static TSharedPtr<FVaultLibrarySnapshot, ESPMode::ThreadSafe> Build(const TSharedPtr<const FVaultLibrarySnapshot, ESPMode::ThreadSafe>& Previous, const FString& LibraryRoot, const TSet<FName>* OnlyFileIds = nullptr,
+		const TMap<FString, FDateTime>* KnownDirectoryTimes = nullptr, TMap<FString, FDateTime>* OutDirectoryTimes = nullptr);
+};
+
+typedef TSharedPtr<const FVaultLibrarySnapshot, ESPMode::ThreadSafe> FVaultLibrarySnapshotPtr;
@@ -0,0 +1,73 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "VaultConnectionMonitor.h"
+
+struct FFileChangeData;
+
+/**
+ * Watches the asset library root so packs published by other users show up without pressing Refresh.
+ * File notifications are collected per FileId and flushed as one targeted cache update once the burst settles.
+ * Shares that never deliver notifications are covered by a slow stat-only poll.
+ * Registering for notifications opens the root on the share, so it waits until the connection monitor has reached it.
+ */
+class VAULT_API FVaultLibraryWatcher
+{
+public:
+
+	~FVaultLibraryWatcher();
+
+	// Start watching a library root. Stops watching the previous root, if any.
+	void Start(const FString& InLibraryRoot);
+
+	void Stop();
+
+	// How long the folder has to be quiet before pending changes are applied.
+	static const double CoalesceSeconds;
+
+	// Upper bound on how long a continuous stream of events can delay an update.
+	static const double MaxCoalesceSeconds;
+
+	// Polls replay the library journal. This often one stats every pack instead, for changes the journal never got.
+	static const double StatRescanInterval;
+
+private:
+
+	void OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+
+	void OnConnectionStateChanged(EVaultConnectionState State);
+
+	// Register for notifications on the root. Game thread only, and only once the root is known to answer.
+	void RegisterNotifications();
+
+	// Poll from the settings, or the default one while notifications aren't coming in.
+	void UpdatePollInterval();
+
+	bool Tick(float DeltaTime);
+
+	FString LibraryRoot;
+
+	FDelegateHandle WatcherHandle;
+	FDelegateHandle TickerHandle;
+	FDelegateHandle ConnectionStateHandle;
+
+	bool bIsWatching = false;
+
+	// FileIds touched since the last flush, and whether any of them had a new thumbnail.
+	TSet<FName> PendingFileIds;
+	TSet<FName> PendingThumbnailFileIds;
+
+	// The sharded layout marker came or went, the next tick does a full rescan.
+	bool bLayoutChanged = false;
+
+	double FirstPendingEventTime = 0.0;
+	double LastPendingEventTime = 0.0;
+
+	// Poll interval in seconds, 0 disables polling.
+	double PollInterval = 0.0;
+	double LastPollTime = 0.0;
+	double LastStatRescanTime = 0.0;
+};
@@ -0,0 +1,91 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "VaultTypes.h"
+#include "VaultLibrarySnapshot.h"
+#include "VaultLibraryQuery.h"
+
+/**
+ * One search of the loader window, run on the thread pool.
+ * It only reads an immutable library snapshot, so it needs no locks. Matches are handed to the game thread in batches as they
+ * are found, already in display order, so the first results show while the rest of the library is still being searched.
+ * A search that is cancelled stops at its next check and never reports again.
+ */
+class VAULT_API FVaultLoaderSearch : public TSharedFromThis<FVaultLoaderSearch, ESPMode::ThreadSafe>
+{
+public:
+
+	enum class EMode : uint8
+	{
+		// Substring match on pack names, or also on authors, descriptions and tags.
+		Plain,
+		// Typo tolerant and ranked, see FVaultFuzzySearch. Falls back to Plain for queries too short to rank.
+		Fuzzy,
+		// Keys and operators, see FVaultLibraryQuery.
+		Query
+	};
+
+	struct FParams
+	{
+		FVaultLibrarySnapshotPtr Library;
+		FString SearchText;
+		EMode Mode = EMode::Plain;
+
+		// Only match pack names, for the strict search.
+		bool bNameOnly = false;
+
+		// Rows the category, tag and developer filters let through.
+		FVaultRowSet AllowedRows;
+
+		// Results of an earlier plain search for part of SearchText, in display order. Searched instead of AllowedRows
+		// when the search index can't narrow things down.
+		bool bNarrowPrevious = false;
+		TArray<int32> PreviousRows;
+
+		// Compiled query, for EMode::Query. Must not be changed while the search runs.
+		TSharedPtr<const FVaultLibraryQuery, ESPMode::ThreadSafe> Query;
+
+		TEnumAsByte<SortingTypes> SortingType = SortingTypes::Filename;
+		bool bSortReversed = false;
+	};
+
+	// Called on the game thread with each batch of matching rows. The last batch, which may be empty, has bFinished set.
+	typedef TFunction<void(const TArray<int32>& Rows, bool bFinished)> FOnResults;
+
+	// Most rows handed over in one batch, and the longest a found row waits before it is handed over.
+	static const int32 MaxBatchSize;
+	static const double MaxBatchSeconds;
+
+	// Start searching in the background. Game thread only.
+	static TSharedRef<FVaultLoaderSearch, ESPMode::ThreadSafe> Start(FParams Params, FOnResults OnResults);
+
+	// Stop the search and drop any batches still on their way. Game thread only.
+	void Cancel();
+
+	bool IsCancelled() const;
+
+	// What the search was started with. Never changes.
+	const FParams& GetParams() const { return Params; }
+
+private:
+
+	FVaultLoaderSearch(FParams InParams, FOnResults InOnResults);
+
+	void Run();
+
+	// Plain and query mode check of one candidate row.
+	bool Matches(int32 Row, const TArray<int32>& MatchingTagIds) const;
+
+	// Send Rows to the game thread and empty it.
+	void PostBatch(TArray<int32>& Rows, bool bFinished);
+
+	FParams Params;
+
+	// Only touched on the game thread, so it is released there as well.
+	FOnResults OnResults;
+
+	FThreadSafeBool bCancelled;
+};
@@ -4,6 +4,29 @@
 
 #include "CoreMinimal.h"
 #include "Dom/JsonObject.h"
+#include "Misc/ScopeRWLock.h"
+#include "HAL/ThreadSafeBool.h"
+#include "VaultTagPool.h"
+
+struct FFileChangeData;
+
+// The settings values read from the local and global settings files. Never modified once built, safe to keep on any thread.
+struct FVaultSettingsSnapshot
+{
+	FString GlobalSettingsFilePath;
+	FString GlobalTagsPoolFilePath;
+	FString AssetLibraryRoot;
+	FString ThumbnailCacheRoot;
+	FString DeveloperName;
+	double LibraryPollingInterval = 0.0;
+	double ConnectionProbeTimeout = 0.0;
+
+	// Modification times of the files the values were read from, to tell when they need reading again.
+	FDateTime LocalSettingsTimestamp;
+	FDateTime GlobalSettingsTimestamp;
+};
+
+typedef TSharedRef<const FVaultSettingsSnapshot, ESPMode::ThreadSafe> FVaultSettingsSnapshotRef;
 
 // Info for the Vault Settings. Stored in JSON and assessable via this struct
 
@@ -14,7 +37,27 @@ public:
 	/** Singleton Accessor */
 	static FVaultSettings& Get();
 
-	void Initialize();
+	// Read, create and update the settings files. Disk only, safe to call off the game thread.
+	// Returns false if any of them had to be created, which means this is a new install.
+	bool PrepareFiles();
+
+	// Settings folders worth watching: the local one, and those on the share that answered just now.
+	// Registering a watch opens the folder, so a share that doesn't answer would hang the game thread. Call it off the game thread.
+	TArray<FString> FindWatchableDirectories();
+
+	// Watch the given settings folders, and queue the setup wizard for new installs. Game thread only.
+	void Initialize(bool bFilesExisted, const TArray<FString>& WatchDirectories);
+
+	void Shutdown();
+
+	// Current settings values. Never touches the disk, the snapshot is refreshed in the background. Safe to call from any thread.
+	FVaultSettingsSnapshotRef GetSnapshot();
+
+	// Have the background refresh read the settings files again, whatever their timestamps say.
+	void InvalidateSnapshot();
+
+	// How often the settings files' timestamps are compared in the background, for shares that don't send change notifications.
+	static const double SnapshotTimestampCheckInterval;
 
 	// Read Local Settings file return the json object
 	TSharedPtr<FJsonObject> GetVaultLocalSettings();
@@ -23,9 +66,10 @@ public:
 	TSharedPtr<FJsonObject> GetVaultGlobalSettings();
 
 	// Add new Vault Tags. User choice to opt their new tags into the global library
+	// Only appends the tags that are new to the pool, see FVaultTagPool.
 	bool SaveVaultTags(TSet<FString> NewTags);
 
-	// Read Existing Tags from the JSON Tag file
+	// Read Existing Tags from the tag pool. Cached, only goes back to disk for what changed.
 	bool ReadVaultTags(TSet<FString>& OutTags);
 
 	FText GetDefaultDeveloperName();
@@ -35,6 +79,12 @@ public:
 
 	FString GetThumbnailCacheRoot();
 
+	// Seconds between stat-only polls of the library, on top of file change notifications. 0 disables polling.
+	double GetLibraryPollingInterval();
+
+	// Seconds a connection probe may take before the library counts as offline.
+	double GetConnectionProbeTimeout();
+
 	FString GetProjectVaultFolder();
 
 	// Json Reusable Functions
@@ -47,7 +97,11 @@ public:
 	static const FString DefaultGlobalsPath;
 	static const FString LocalSettingsFilePathFull;
 	static const FString DefaultThumbnailCacheFolder;
+	static const FString LibraryCacheFolderFull;
+	static const double DefaultLibraryPollingInterval;
+	static const double DefaultConnectionProbeTimeout;
 
+	// Blocks on the share until it answers. Only the connection monitor calls this, everyone else asks FVaultConnectionMonitor.
 	bool CheckConnection();
 
 private:
@@ -55,6 +109,21 @@ private:
 	// Easy write to file
 	bool WriteJsonObjectToFile(TSharedPtr<FJsonObject> JsonFile, FString FilepathFull);
 
+	static TSharedPtr<FJsonObject> ReadJsonObjectFromFile(const FString& FilepathFull);
+
+	static FVaultSettingsSnapshotRef LoadSnapshot();
+
+	// Read the settings files again if their timestamps changed, or always with bForce, and swap the snapshot.
+	// Blocks on the share, never call it from the game thread but through StartSnapshotRefresh.
+	void RefreshSnapshot(bool bForce);
+
+	// Run RefreshSnapshot on the thread pool, unless one is already running.
+	void StartSnapshotRefresh();
+
+	bool TickSnapshotRefresh(float DeltaTime);
+
+	void OnSettingsDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+
 	// Generates the default local settings file for new installs
 	void GenerateBaseLocalSettingsFile();
 
@@ -75,6 +144,20 @@ private:
 	FDelegateHandle LoadedDelegateHandle;
 	void OnEditorLoaded(SWindow& SlateWindow, void* ViewportRHIPtr);
 
-	//if we are connected to the global vault path
-	bool IsConnected;
+	// Only held to copy or swap the pointer.
+	FRWLock SnapshotLock;
+	FVaultSettingsSnapshotRef Snapshot = MakeShared<FVaultSettingsSnapshot, ESPMode::ThreadSafe>();
+
+	// Serializes refreshes, so an older read never replaces a newer one.
+	FCriticalSection RefreshLock;
+	bool bSnapshotLoaded = false;
+
+	FThreadSafeBool bSnapshotDirty = true;
+	FThreadSafeBool bSnapshotRefreshInFlight = false;
+	FDelegateHandle SnapshotTickerHandle;
+
+	FVaultTagPool TagPool;
+
+	// Settings directories we watch, and their watcher handles.
+	TArray<TPair<FString, FDelegateHandle>> WatchedDirectories;
 };
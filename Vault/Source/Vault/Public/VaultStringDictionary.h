@@ -0,0 +1,41 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+/**
+ * Maps strings to dense integer ids, so library-wide values like tags can be counted and compared as ints.
+ * Append-only and thread safe. Ids stay valid for the lifetime of the editor, which makes them safe to keep in library snapshots.
+ * Matching is case-insensitive, the same as TSet<FString>.
+ */
+class VAULT_API FVaultStringDictionary
+{
+public:
+
+	// Shared dictionary for FVaultMetadata::Tags.
+	static FVaultStringDictionary& Tags();
+
+	// Shared dictionary for FVaultMetadata::Author.
+	static FVaultStringDictionary& Authors();
+
+	int32 FindOrAdd(const FString& String);
+
+	// INDEX_NONE if the string has never been added.
+	int32 Find(const FString& String) const;
+
+	FString GetString(int32 Id) const;
+
+	int32 Num() const;
+
+	// Ids of every string containing Substring, sorted.
+	TArray<int32> FindIdsContaining(const FString& Substring) const;
+
+private:
+
+	mutable FRWLock Lock;
+
+	TMap<FString, int32> IdsByString;
+	TArray<FString> Strings;
+};
@@ -13,8 +13,13 @@ public:
 
 	static void Shutdown();
 
+	// Sync the local thumbnail cache with the packs of the current library snapshot. Returns false if there is no snapshot yet.
 	static bool CacheThumbnailsLocally();
 
+	// Refresh the cached thumbnail of a single pack. Removes the cached copy if the pack no longer has one.
+	// Reads the share, so keep it off the game thread.
+	static void CacheThumbnailLocally(FName FileId);
+
 	/** reloads textures used by slate renderer */
 	static void ReloadTextures();
 
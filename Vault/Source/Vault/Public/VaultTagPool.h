@@ -0,0 +1,60 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The global tag pool, shared by every editor through the settings folder.
+ * VaultTags.json holds the compacted pool. New tags are appended to VaultTags.json.log, one per line, so publishers never
+ * rewrite the pool or wait on each other. Once the log grows too big it is sealed under a unique name and folded into the pool.
+ * Sealed logs are only deleted well after their tags made it into the pool, so two editors compacting at once lose nothing.
+ * Reads are cached and only pick up what changed on disk since the last one.
+ */
+class VAULT_API FVaultTagPool
+{
+public:
+
+	// The log is compacted once it grows past this many bytes.
+	static const int64 MaxLogSize;
+
+	// How long a sealed log is kept after its tags were folded into the pool.
+	static const FTimespan SealedLogRetention;
+
+	static FString GetLogFilePath(const FString& PoolFilePath);
+
+	// Write a fresh pool file holding only these tags. For new installs.
+	static bool CreatePool(const FString& PoolFilePath, const TSet<FString>& Tags);
+
+	// Fold the log into the pool file.
+	static bool Compact(const FString& PoolFilePath);
+
+	// Append the tags the pool doesn't have yet. Never rewrites the pool, safe while other editors do the same.
+	bool Add(const FString& PoolFilePath, const TSet<FString>& NewTags);
+
+	// Every tag in the pool, its log and any sealed logs. False if there is no pool file.
+	bool Get(const FString& PoolFilePath, TSet<FString>& OutTags);
+
+	// Make the next Get check the files again rather than wait for the next timestamp check.
+	void Invalidate();
+
+private:
+
+	// Bring the cache up to date with the files. Callers hold CacheLock.
+	void Refresh(const FString& PoolFilePath);
+
+	FCriticalSection CacheLock;
+
+	FString CachedPoolFilePath;
+	TSet<FString> CachedTags;
+	bool bPoolExists = false;
+
+	// Modification time of the pool file the cache was built from.
+	FDateTime PoolTimestamp;
+
+	// Bytes of the log read so far, up to the last complete line.
+	int64 LogOffset = 0;
+
+	double LastCheckTime = 0.0;
+	bool bDirty = true;
+};
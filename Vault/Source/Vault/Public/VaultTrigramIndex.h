@@ -0,0 +1,74 @@
+// Copyright Daniel Orchard 2020
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "VaultTypes.h"
+#include "VaultLibraryIndex.h"
+
+/**
+ * Posting lists of every case-insensitive trigram in the searchable fields of a library snapshot.
+ * A search of at least MinQueryLength characters intersects the lists of its trigrams to get the few rows that can contain it,
+ * which are then confirmed with the exact check. Pack names get their own lists for the strict search.
+ * Bigram lists over pack names and tags serve fuzzy queries too short to be sure of sharing a trigram with their matches.
+ */
+struct VAULT_API FVaultTrigramIndex
+{
+	static const int32 MinQueryLength;
+
+	// Rows whose pack name contains the trigram, ascending.
+	TMap<uint64, TArray<int32>> NameRows;
+
+	// Rows whose pack name, author, description or any tag contains the trigram, ascending.
+	TMap<uint64, TArray<int32>> TextRows;
+
+	// Rows whose pack name contains the bigram, ascending.
+	TMap<uint64, TArray<int32>> NameBigramRows;
+
+	// Rows whose pack name or any tag contains the bigram, ascending. Descriptions are left out, a long one has most
+	// common bigrams and would put nearly every row on every list.
+	TMap<uint64, TArray<int32>> KeywordBigramRows;
+
+	/**
+	 * Index the records. Packs whose .meta stat is the same as in Previous reuse the n-grams taken there,
+	 * so only packs that changed since the last snapshot are tokenized again.
+	 */
+	void Build(const TArray<FVaultMetadata>& Assets, const TMap<FName, FVaultMetaFileStat>& Stats, const FVaultTrigramIndex* Previous);
+
+	// Every row that can contain Query, ascending. False if the query is too short to use the index.
+	// Both lookups stop early once bCancelled is set, leaving OutRows incomplete.
+	bool FindCandidates(const FString& Query, bool bNameOnly, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled = nullptr) const;
+
+	// Rows sharing at least MinShared distinct trigrams with Query, ascending. For searches that tolerate typos.
+	void FindRowsSharingTrigrams(const FString& Query, bool bNameOnly, int32 MinShared, int32 NumRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled = nullptr) const;
+
+	// Rows whose pack name, or unless bNameOnly any tag, shares at least MinShared distinct bigrams with Query, ascending.
+	void FindRowsSharingBigrams(const FString& Query, bool bNameOnly, int32 MinShared, int32 NumRows, TArray<int32>& OutRows, const FThreadSafeBool* bCancelled = nullptr) const;
+
+	// Distinct trigrams of Query. Case-insensitive like the index.
+	static int32 CountDistinctTrigrams(const FString& Query);
+
+	// Distinct bigrams of Query. Case-insensitive like the index.
+	static int32 CountDistinctBigrams(const FString& Query);
+
+	// Lowercase trigrams of Text in order, duplicates included, appended to OutTrigrams.
+	static void GetTrigrams(const FString& Text, TArray<uint64>& OutTrigrams);
+
+	// Lowercase bigrams of Text in order, duplicates included, appended to OutBigrams.
+	static void GetBigrams(const FString& Text, TArray<uint64>& OutBigrams);
+
+private:
+
+	struct FPackGrams
+	{
+		FVaultMetaFileStat Stat;
+		TArray<uint64> Name;
+		TArray<uint64> Text;
+		TArray<uint64> NameBigrams;
+		TArray<uint64> KeywordBigrams;
+	};
+
+	// N-grams of every pack as of its .meta stat, for the next build to reuse.
+	TMap<FName, FPackGrams> GramsByFileId;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/Texture2DDynamic.h"
+#include "Algo/BinarySearch.h"
 
 UENUM()
 enum FVaultCategory
@@ -37,6 +38,23 @@ public:
 	FString MachineID;
 	TSet<FString> ObjectsInPack;
 
+	// False for library records read without their heavy fields (ObjectsInPack). Call FMetadataOps::LoadDetails before using them.
+	bool bDetailsLoaded;
+
+	// Tags as sorted ids into FVaultStringDictionary::Tags(), so filtering and counting never touch the strings. Filled by InternStrings.
+	TArray<int32> TagIds;
+
+	// Author as an id into FVaultStringDictionary::Authors(). Filled by InternStrings.
+	int32 AuthorId;
+
+	// Refresh TagIds and AuthorId from Tags and Author.
+	void InternStrings();
+
+	bool HasTagId(int32 TagId) const
+	{
+		return Algo::BinarySearch(TagIds, TagId) != INDEX_NONE;
+	}
+
 	/// <summary>
 	/// The higher the value the worse it is.
 	/// 0 for good hierarchy
@@ -47,12 +65,6 @@ public:
 	/// </summary>
 	int32 HierarchyBadness;
 
-	/** Get the event fired whenever a rename is requested */
-	FSimpleDelegate& OnRenameRequested();
-
-	/** Get the event fired whenever a rename is canceled */
-	FSimpleDelegate& OnRenameCanceled();
-
 	static FString CategoryToString(FVaultCategory InCategory);
 
 	static FVaultCategory StringToCategory(FString InString);
@@ -65,13 +77,6 @@ public:
 
 	int32 InProjectVersion;
 
-protected:
-
-	FSimpleDelegate RenameRequestedEvent;
-
-	FSimpleDelegate RenameCanceledEvent;
-
-public:
 	// Constructor
 	FVaultMetadata()
 	{
@@ -84,9 +89,12 @@ public:
 		RelativePath = FString();
 		MachineID = FString();
 		Category = FVaultCategory::Unknown;
+		InProjectVersion = 0;
+		AuthorId = INDEX_NONE;
+		bDetailsLoaded = true;
 	}
 
-	bool IsMetaValid()
+	bool IsMetaValid() const
 	{
 		return PackName != NAME_None && FileId != NAME_None;
 	}
@@ -94,10 +102,10 @@ public:
 	bool operator==(const FVaultMetadata& V) const;
 };
 
+// FileId identifies a pack, records that compare equal always share it.
 FORCEINLINE uint32 GetTypeHash(const FVaultMetadata& V)
 {
-	const FString ComboString = V.PackName.ToString() + V.FileId.ToString() + V.Author.ToString() + V.Description + V.CreationDate.ToString();
-	return GetTypeHash(ComboString);
+	return GetTypeHash(V.FileId);
 }
 
 FORCEINLINE bool FVaultMetadata::operator==(const FVaultMetadata& V) const
@@ -126,6 +134,7 @@ struct FTagFilteringItem
 	FTagFilteringItem() {}
 	virtual ~FTagFilteringItem() {}
 	FString Tag;
+	int32 TagId = INDEX_NONE;
 	int UseCount;
 };
 
@@ -40,7 +40,8 @@ public class Vault : ModuleRules
 				"DesktopPlatform",
 				"ImageWriteQueue",
 				"EditorScriptingUtilities",
-				"Blutility"
+				"Blutility",
+				"DirectoryWatcher" // live library updates
 			});
 	}
 }